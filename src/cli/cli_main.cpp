@@ -13,13 +13,36 @@
 #include <script/functions/functions.hpp>
 #include <script/profiler.hpp>
 #include <data/format/formats.hpp>
+#include <data/card.hpp>
+#include <data/game.hpp>
+#include <data/keyword.hpp>
+#include <data/field/text.hpp>
+#include <data/stylesheet.hpp>
+#include <data/settings.hpp>
+#include <gfx/image_cache.hpp>
+#include <util/tagged_string.hpp>
+#include <render/text/viewer.hpp> // text_layout_stats
+#include <wx/stopwatch.h>
 #include <wx/process.h>
 #include <wx/wfstream.h>
 
 String read_utf8_line(wxInputStream& input, bool until_eof = false);
+ScriptValueP export_set(SetP const& set, vector<CardP> const& cards, ExportTemplateP const& exp, String const& outname);
 
 // ----------------------------------------------------------------------------- : Command line interface
 
+/// When was a set file last saved? 0 if it doesn't exist
+/** A set can also be stored as a directory, then the time of the directory itself doesn't change
+ *  when the set is saved, but that of the "set" file inside it does.
+ */
+static time_t set_modification_time(const String& filename) {
+  if (wxDirExists(filename)) {
+    String set_file = filename + _("/set");
+    return wxFileExists(set_file) ? wxFileModificationTime(set_file) : 0;
+  }
+  return wxFileExists(filename) ? wxFileModificationTime(filename) : 0;
+}
+
 CLISetInterface::CLISetInterface(const SetP& set, bool quiet, bool run)
   : quiet(quiet)
   , our_context(nullptr)
@@ -29,6 +52,10 @@ CLISetInterface::CLISetInterface(const SetP& set, bool quiet, bool run)
   }
   ei.allow_writes_outside = true;
   setExportInfoCwd();
+  if (set) {
+    time_t modified = set_modification_time(set->absoluteFilename());
+    if (modified) open_sets[set->absoluteFilename()] = OpenSet{set, modified};
+  }
   setSet(set);
   if (run) this->run();
 }
@@ -67,6 +94,67 @@ void CLISetInterface::setExportInfoCwd() {
   ei.export_template->open(ei.directory_absolute, true);
 }
 
+void CLISetInterface::loadSet(const String& filename) {
+  wxFileName fn(filename);
+  fn.MakeAbsolute();
+  String key = fn.GetFullPath();
+  time_t modified = set_modification_time(key);
+  auto it = open_sets.find(key);
+  if (it == open_sets.end() || it->second.modified != modified) {
+    SetP new_set = import_set(key);
+    it = open_sets.insert_or_assign(key, OpenSet{new_set, modified}).first;
+  }
+  setSet(it->second.set);
+}
+
+void CLISetInterface::closeSet(const String& filename) {
+  String key;
+  if (filename.empty()) {
+    if (!set) throw Error(_("No set loaded"));
+    FOR_EACH(s, open_sets) {
+      if (s.second.set == set) key = s.first;
+    }
+  } else {
+    wxFileName fn(filename);
+    fn.MakeAbsolute();
+    key = fn.GetFullPath();
+  }
+  auto it = open_sets.find(key);
+  if (it != open_sets.end()) {
+    if (it->second.set == set) setSet(SetP());
+    open_sets.erase(it);
+  } else if (filename.empty()) {
+    setSet(SetP()); // the set was not loaded from a file
+  } else {
+    throw Error(_("Set is not open: ") + filename);
+  }
+}
+
+void CLISetInterface::showSets() {
+  FOR_EACH(s, open_sets) {
+    cli << (s.second.set == set ? _("* ") : _("  ")) << s.first << ENDL;
+  }
+}
+
+void CLISetInterface::renderCard(const String& card_name, const String& filename) {
+  CardP card;
+  unsigned long index;
+  if (card_name.ToULong(&index)) {
+    if (index >= set->cards.size()) throw Error(String::Format(_("There is no card at position %lu"), index));
+    card = set->cards[index];
+  } else {
+    FOR_EACH(c, set->cards) {
+      if (c->identification() == card_name) {
+        card = c;
+        break;
+      }
+    }
+    if (!card) throw Error(_("There is no card named ") + card_name);
+  }
+  Image img = export_image(set, card);
+  if (!img.SaveFile(filename)) throw Error(_("Unable to write image file: ") + filename);
+}
+
 
 // ----------------------------------------------------------------------------- : Running
 
@@ -109,10 +197,20 @@ void CLISetInterface::run() {
     // read line from stdin
     String command = cli.getLine();
     if (command.empty() && !cli.canGetLine()) break;
+    // in raw mode a command can start with "#<id> ", the id is repeated in the record of the response
+    String request_id;
+    if (cli.rawMode() && command.size() > 1 && command.GetChar(0) == _('#')) {
+      size_t end = 1;
+      while (end < command.size() && (isAlnum(command.GetChar(end)) || command.GetChar(end) == _('-') || command.GetChar(end) == _('_'))) ++end;
+      if (end > 1 && (end == command.size() || command.GetChar(end) == _(' '))) {
+        request_id = command.substr(1, end - 1);
+        command = end < command.size() ? command.substr(end + 1) : String();
+      }
+    }
     handleCommand(command);
     cli.print_pending_errors();
     cli.flush();
-    cli.flushRaw();
+    cli.flushRaw(request_id);
   }
 }
 
@@ -131,11 +229,30 @@ void CLISetInterface::showUsage() {
   cli << _("   <expression>        Execute a script expression, display the result\n");
   cli << _("   :help               Show this help page.\n");
   cli << _("   :load <setfile>     Load a different set file.\n");
+  cli << _("                       Sets stay open, loading a set again is instant unless the file changed.\n");
+  cli << _("   :sets               List the open sets.\n");
+  cli << _("   :close [<setfile>]  Close a set, or the current set.\n");
+  cli << _("   :export <template> [<outfile>]\n");
+  cli << _("                       Export the current set with an export template.\n");
+  cli << _("   :images [<image>]   Export the cards of the current set to image files,\n");
+  cli << _("                       <image> is the same format as for 'export all card images'.\n");
+  cli << _("   :render <card> <image>\n");
+  cli << _("                       Render a single card of the current set to an image file,\n");
+  cli << _("                       <card> is the position of the card in the set, or its name.\n");
   cli << _("   :quit               Exit the MSE command line interface.\n");
   cli << _("   :reset              Clear all local variable definitions.\n");
   cli << _("   :pwd                Print the current working directory.\n");
   cli << _("   :cd                 Change the working directory.\n");
   cli << _("   :! <command>        Perform a shell command.\n");
+  cli << _("   :diagnostics        Show statistics about internal caches.\n");
+  cli << _("   :benchmark [<n>]    Render all cards once with empty caches, and then n more times.\n");
+  cli << _("   :benchmark keywords [<n>]\n");
+  cli << _("                       Find the keywords in all text on the cards n times.\n");
+  cli << _("   :benchmark extents [<n>]\n");
+  cli << _("                       Measure all lines of text on the cards n times, per prefix and per line,\n");
+  cli << _("                       and report the lines where the widths differ.\n");
+  cli << _("   :benchmark tags [<n>]\n");
+  cli << _("                       Map cursor positions in all text of the set n times, with and without a tag index.\n");
   cli << _("\n Commands can be abreviated to their first letter if there is no ambiguity.\n\n");
 }
 
@@ -159,7 +276,39 @@ void CLISetInterface::handleCommand(const String& command) {
         if (arg.empty()) {
           cli.show_message(MESSAGE_ERROR,_("Give a filename to open."));
         } else {
-          setSet(import_set(arg));
+          loadSet(arg);
+        }
+      } else if (before == _(":s") || before == _(":sets")) {
+        showSets();
+      } else if (before == _(":close")) {
+        closeSet(arg);
+      } else if (before == _(":e") || before == _(":export")) {
+        String name = arg.BeforeFirst(_(' '));
+        String out  = arg.AfterFirst(_(' '));
+        if (!set) {
+          cli.show_message(MESSAGE_ERROR,_("No set loaded"));
+        } else if (name.empty()) {
+          cli.show_message(MESSAGE_ERROR,_("Give an export template."));
+        } else {
+          ExportTemplateP exp = ExportTemplate::byName(name);
+          ScriptValueP result = export_set(set, set->cards, exp, out);
+          if (out.empty()) cli << result->toString() << ENDL;
+        }
+      } else if (before == _(":images")) {
+        if (!set) {
+          cli.show_message(MESSAGE_ERROR,_("No set loaded"));
+        } else {
+          export_images(set, arg);
+        }
+      } else if (before == _(":render")) {
+        String card = arg.BeforeLast(_(' '));
+        String out  = arg.AfterLast(_(' '));
+        if (!set) {
+          cli.show_message(MESSAGE_ERROR,_("No set loaded"));
+        } else if (card.empty() || out.empty()) {
+          cli.show_message(MESSAGE_ERROR,_("Give a card and an image filename."));
+        } else {
+          renderCard(card, out);
         }
       } else if (before == _(":r") || before == _(":reset")) {
         Context& ctx = getContext();
@@ -187,6 +336,26 @@ void CLISetInterface::handleCommand(const String& command) {
         }
       } else if (before == _(":pwd") || before == _(":p")) {
         cli << ei.directory_absolute << ENDL;
+      } else if (before == _(":d") || before == _(":diagnostics")) {
+        showDiagnostics();
+      } else if (before == _(":b") || before == _(":benchmark")) {
+        String what = arg.BeforeFirst(_(' '));
+        if (what == _("layout") || what == _("keywords") || what == _("tags") || what == _("extents")) {
+          arg = arg.AfterFirst(_(' '));
+        } else {
+          what = _("layout");
+        }
+        long repeat = 1;
+        arg.ToLong(&repeat);
+        if (what == _("keywords")) {
+          benchmarkKeywords(max(1, (int)repeat));
+        } else if (what == _("tags")) {
+          benchmarkTags(max(1, (int)repeat));
+        } else if (what == _("extents")) {
+          benchmarkExtents(max(1, (int)repeat));
+        } else {
+          benchmarkLayout(max(1, (int)repeat));
+        }
       } else if (before == _(":!")) {
         if (arg.empty()) {
           cli.show_message(MESSAGE_ERROR,_("Give a shell command to execute."));
@@ -231,6 +400,7 @@ void CLISetInterface::handleCommand(const String& command) {
       WITH_DYNAMIC_ARG(export_info, &ei);
       Context& ctx = getContext();
       ScriptValueP result = ctx.eval(*script,false);
+      ei.finish(); // close files written by the command
       // show result
       cli << result->toCode() << ENDL;
     }
@@ -239,6 +409,224 @@ void CLISetInterface::handleCommand(const String& command) {
   }
 }
 
+void CLISetInterface::showDiagnostics() {
+  ImageCache::Stats images = image_cache.stats();
+  cli << BRIGHT << _("Image cache") << NORMAL << ENDL;
+  cli << String::Format(_("  images:    %d"), (int)images.entries) << ENDL;
+  cli << String::Format(_("  memory:    %.1f / %.1f MB"), images.bytes / 1048576.0, images.budget / 1048576.0) << ENDL;
+  cli << String::Format(_("  hits:      %d"), (int)images.hits) << ENDL;
+  cli << String::Format(_("  misses:    %d"), (int)images.misses) << ENDL;
+  cli << String::Format(_("  evictions: %d"), (int)images.evictions) << ENDL;
+  TextExtentCache::Stats extents = text_extent_cache.stats();
+  cli << BRIGHT << _("Text extent cache") << NORMAL << ENDL;
+  cli << String::Format(_("  extents:   %d"), (int)extents.entries) << ENDL;
+  cli << String::Format(_("  memory:    %.1f / %.1f MB"), extents.bytes / 1048576.0, extents.budget / 1048576.0) << ENDL;
+  cli << String::Format(_("  hits:      %d"), (int)extents.hits) << ENDL;
+  cli << String::Format(_("  misses:    %d"), (int)extents.misses) << ENDL;
+  cli << String::Format(_("  evictions: %d"), (int)extents.evictions) << ENDL;
+  vector<TextLayoutStats::Field> layouts = text_layout_stats.fields();
+  if (!layouts.empty()) {
+    cli << BRIGHT << _("Text layout attempts per field") << NORMAL << ENDL;
+    cli << GRAY << _("  layouts  attempts  max  field") << NORMAL << ENDL;
+    FOR_EACH(f, layouts) {
+      cli << String::Format(_("  %7d  %8d  %3d  "), (int)f.layouts, (int)f.attempts, (int)f.max_attempts) << f.name << ENDL;
+    }
+  }
+  if (set) {
+    KeywordDatabase::ExpansionStats expansions = set->keyword_db.expansionStats();
+    cli << BRIGHT << _("Keyword expansions") << NORMAL << ENDL;
+    cli << String::Format(_("  cached:    %d"), (int)expansions.entries) << ENDL;
+    cli << String::Format(_("  hits:      %d"), (int)expansions.hits) << ENDL;
+    cli << String::Format(_("  misses:    %d"), (int)expansions.misses) << ENDL;
+    cli << String::Format(_("  forgotten: %d"), (int)expansions.forgotten) << ENDL;
+  }
+}
+
+void CLISetInterface::benchmarkLayout(int repeat) {
+  if (!set) {
+    cli.show_message(MESSAGE_ERROR,_("No set loaded"));
+    return;
+  }
+  // render all cards, the first time with an empty text extent cache
+  text_extent_cache.clear();
+  wxStopWatch stopwatch;
+  FOR_EACH(card, set->cards) {
+    export_image(set, card);
+  }
+  long time_first = stopwatch.Time();
+  stopwatch.Start();
+  for (int i = 0 ; i < repeat ; ++i) {
+    FOR_EACH(card, set->cards) {
+      export_image(set, card);
+    }
+  }
+  long time_again = stopwatch.Time();
+  cli << BRIGHT << String::Format(_("Rendered %d cards %d times"), (int)set->cards.size(), repeat + 1) << NORMAL << ENDL;
+  cli << String::Format(_("  first time:          %ld ms"), time_first) << ENDL;
+  cli << String::Format(_("  afterwards, average: %ld ms"), time_again / repeat) << ENDL;
+}
+
+void CLISetInterface::benchmarkKeywords(int repeat) {
+  if (!set) {
+    cli.show_message(MESSAGE_ERROR,_("No set loaded"));
+    return;
+  }
+  KeywordDatabase& db = set->keyword_db;
+  if (db.empty()) {
+    db.prepare_parameters(set->game->keyword_parameter_types, set->keywords);
+    db.prepare_parameters(set->game->keyword_parameter_types, set->game->keywords);
+    db.add(set->keywords);
+    db.add(set->game->keywords);
+  }
+  // all text on the cards
+  vector<String> texts;
+  FOR_EACH(card, set->cards) {
+    FOR_EACH(value, card->data) {
+      if (TextValue* text = dynamic_cast<TextValue*>(value.get())) {
+        texts.push_back(text->value());
+      }
+    }
+  }
+  size_t candidates = 0, matches = 0;
+  db.countMatches(String(), candidates); // builds the matcher, which is not what we are timing
+  candidates = 0;
+  wxStopWatch stopwatch;
+  for (int i = 0 ; i < repeat ; ++i) {
+    FOR_EACH(text, texts) {
+      matches += db.countMatches(text, candidates);
+    }
+  }
+  long time = stopwatch.Time();
+  size_t keywords = set->keywords.size() + set->game->keywords.size();
+  cli << BRIGHT << String::Format(_("Matched %d keywords in %d texts %d times"), (int)keywords, (int)texts.size(), repeat) << NORMAL << ENDL;
+  cli << String::Format(_("  time:                 %ld ms"), time) << ENDL;
+  cli << String::Format(_("  candidates per text:  %.1f"), texts.empty() ? 0. : candidates / (double)(texts.size() * repeat)) << ENDL;
+  cli << String::Format(_("  matches:              %d"), (int)(matches / repeat)) << ENDL;
+}
+
+void CLISetInterface::benchmarkExtents(int repeat) {
+  if (!set) {
+    cli.show_message(MESSAGE_ERROR,_("No set loaded"));
+    return;
+  }
+  // all lines of text on the cards, with the font of their field
+  vector<pair<wxFont,String>> lines;
+  FOR_EACH(card, set->cards) {
+    StyleSheetP stylesheet = set->stylesheetForP(card);
+    FOR_EACH(value, card->data) {
+      TextValue* text = dynamic_cast<TextValue*>(value.get());
+      if (!text) continue;
+      TextStyle* style = dynamic_cast<TextStyle*>(stylesheet->card_style[value->fieldP].get());
+      if (!style) continue;
+      wxFont font = style->font.toWxFont(1.0);
+      String untagged = untag(text->value());
+      size_t start = 0;
+      while (start < untagged.size()) {
+        size_t end = min(untagged.find_first_of(_('\n'), start), untagged.size());
+        if (end > start) lines.push_back(make_pair(font, untagged.substr(start, end - start)));
+        start = end + 1;
+      }
+    }
+  }
+  // measure directly on a dc, in device units, without the text extent cache
+  Bitmap bitmap(1, 1);
+  wxMemoryDC dc;
+  dc.SelectObject(bitmap);
+  vector<vector<int>> by_prefix(lines.size()), by_line(lines.size());
+  wxArrayInt partial;
+  wxStopWatch stopwatch;
+  for (int i = 0 ; i < repeat ; ++i) {
+    for (size_t j = 0 ; j < lines.size() ; ++j) {
+      const String& line = lines[j].second;
+      dc.SetFont(lines[j].first);
+      by_prefix[j].clear();
+      for (size_t k = 1 ; k <= line.size() ; ++k) {
+        int w, h;
+        dc.GetTextExtent(line.substr(0, k), &w, &h);
+        by_prefix[j].push_back(w);
+      }
+    }
+  }
+  long time_prefix = stopwatch.Time();
+  stopwatch.Start();
+  for (int i = 0 ; i < repeat ; ++i) {
+    for (size_t j = 0 ; j < lines.size() ; ++j) {
+      dc.SetFont(lines[j].first);
+      dc.GetPartialTextExtents(lines[j].second, partial);
+      by_line[j].assign(partial.begin(), partial.end());
+    }
+  }
+  long time_line = stopwatch.Time();
+  dc.SelectObject(wxNullBitmap);
+  // compare, the widths should be identical
+  int different = 0;
+  for (size_t j = 0 ; j < lines.size() ; ++j) {
+    if (by_prefix[j] != by_line[j]) {
+      if (different < 10) {
+        size_t k = 0;
+        while (k < by_prefix[j].size() && k < by_line[j].size() && by_prefix[j][k] == by_line[j][k]) ++k;
+        cli << GRAY << _("  different: ") << NORMAL << lines[j].second
+            << String::Format(_(" (from character %d)"), (int)k) << ENDL;
+      }
+      ++different;
+    }
+  }
+  cli << BRIGHT << String::Format(_("Measured %d lines of text %d times"), (int)lines.size(), repeat) << NORMAL << ENDL;
+  cli << String::Format(_("  measure per prefix:  %ld ms"), time_prefix) << ENDL;
+  cli << String::Format(_("  measure per line:    %ld ms"), time_line) << ENDL;
+  cli << String::Format(_("  different lines:     %d"), different) << ENDL;
+}
+
+void CLISetInterface::benchmarkTags(int repeat) {
+  if (!set) {
+    cli.show_message(MESSAGE_ERROR,_("No set loaded"));
+    return;
+  }
+  // all text on the cards, as one long text
+  String text;
+  FOR_EACH(card, set->cards) {
+    FOR_EACH(value, card->data) {
+      if (TextValue* t = dynamic_cast<TextValue*>(value.get())) {
+        if (!text.empty()) text += _("\n");
+        text += t->value();
+      }
+    }
+  }
+  // map positions spread over the text to cursor positions and back, like the text editor does
+  const size_t samples = 1000;
+  size_t step = max((size_t)1, text.size() / samples);
+  vector<size_t> plain, indexed;
+  wxStopWatch stopwatch;
+  for (int i = 0 ; i < repeat ; ++i) {
+    plain.clear();
+    for (size_t index = 0 ; index < text.size() ; index += step) {
+      size_t cursor = index_to_cursor(text, index, MOVE_MID);
+      plain.push_back(cursor_to_index(text, cursor, MOVE_MID));
+      plain.push_back(untagged_to_index(text, index_to_untagged(text, index), true));
+    }
+  }
+  long time_plain = stopwatch.Time();
+  stopwatch.Start();
+  for (int i = 0 ; i < repeat ; ++i) {
+    indexed.clear();
+    TaggedText tagged(text); // includes the time for parsing
+    for (size_t index = 0 ; index < text.size() ; index += step) {
+      size_t cursor = tagged.indexToCursor(index, MOVE_MID);
+      indexed.push_back(tagged.cursorToIndex(cursor, MOVE_MID));
+      indexed.push_back(tagged.untaggedToIndex(tagged.indexToUntagged(index), true));
+    }
+  }
+  long time_indexed = stopwatch.Time();
+  int different = 0;
+  for (size_t i = 0 ; i < plain.size() ; ++i) {
+    if (plain[i] != indexed[i]) ++different;
+  }
+  cli << BRIGHT << String::Format(_("Mapped %d positions in %d characters %d times"), (int)(plain.size() / 2), (int)text.size(), repeat) << NORMAL << ENDL;
+  cli << String::Format(_("  scanning the text:    %ld ms"), time_plain) << ENDL;
+  cli << String::Format(_("  with a tag index:     %ld ms"), time_indexed) << ENDL;
+  cli << String::Format(_("  different results:    %d"), different) << ENDL;
+}
+
 #if USE_SCRIPT_PROFILING
   void CLISetInterface::showProfilingStats(const FunctionProfile& item, int level) {
     // show parent
@@ -31,6 +31,15 @@ private:
   void showWelcome();
   void showUsage();
   void handleCommand(const String& command);
+  void loadSet(const String& filename);
+  void closeSet(const String& filename);
+  void showSets();
+  void renderCard(const String& card, const String& filename);
+  void showDiagnostics();
+  void benchmarkLayout(int repeat);
+  void benchmarkKeywords(int repeat);
+  void benchmarkTags(int repeat);
+  void benchmarkExtents(int repeat);
   #if USE_SCRIPT_PROFILING
     void showProfilingStats(const FunctionProfile& parent, int level = 0);
   #endif
@@ -43,6 +52,16 @@ private:
   // export info, so we can write files
   ExportInfo ei;
   void setExportInfoCwd();
+  
+  /// Sets that were loaded, by absolute filename
+  /** They are kept open, so switching back to a set doesn't load it again,
+   *  unless the file was modified in the mean time.
+   */
+  struct OpenSet {
+    SetP   set;
+    time_t modified;
+  };
+  map<String,OpenSet> open_sets;
 };
 
 bool run_script_file(String const& filename);
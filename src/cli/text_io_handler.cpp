@@ -138,7 +138,7 @@ void TextIOHandler::enableRaw() {
   raw_mode_status = 0;
 }
 
-void TextIOHandler::flushRaw() {
+void TextIOHandler::flushRaw(const String& request_id) {
   if (!raw_mode) return;
   // always end in a newline
   if (!buffer.empty() && buffer.GetChar(buffer.size()-1) != _('\n')) {
@@ -148,7 +148,11 @@ void TextIOHandler::flushRaw() {
   int newline_count = 0;
   FOR_EACH_CONST(c,buffer) if (c==_('\n')) newline_count++;
   // write record
-  printf("%d\n%d\n", raw_mode_status, newline_count);
+  if (request_id.empty()) {
+    printf("%d\n%d\n", raw_mode_status, newline_count);
+  } else {
+    printf("%d %s\n%d\n", raw_mode_status, (const char*)request_id.mb_str(wxConvUTF8), newline_count);
+  }
   if (!buffer.empty()) {
     #ifdef UNICODE
       wxCharBuffer buf = buffer.mb_str(wxConvUTF8);
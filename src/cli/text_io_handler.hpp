@@ -42,9 +42,11 @@ public:
   
   /// Enable raw mode
   void enableRaw();
+  inline bool rawMode() const { return raw_mode; }
   /// Output a single raw-mode record
   /// Has no effect unless enableRaw() was called
-  void flushRaw();
+  /// If a request_id is given, it is written after the status code
+  void flushRaw(const String& request_id = String());
   
 private:
   bool have_console;
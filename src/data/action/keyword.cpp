@@ -45,7 +45,9 @@ String AddKeywordAction::getName(bool to_undo) const {
 
 void AddKeywordAction::perform(bool to_undo) {
   action.perform(set.keywords, to_undo);
-  set.keyword_db.clear();
+  FOR_EACH_CONST(step, action.steps) {
+    set.keyword_db.keywordChanged(*step.item, true);
+  }
 }
 
 // ----------------------------------------------------------------------------- : Changing keywords
@@ -0,0 +1,323 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <data/card_search.hpp>
+#include <data/set.hpp>
+#include <data/card.hpp>
+#include <data/field.hpp>
+#include <data/field/text.hpp>
+#include <data/action/value.hpp>
+#include <data/action/set.hpp>
+#include <data/action/keyword.hpp>
+#include <unordered_set>
+
+// ----------------------------------------------------------------------------- : Trigrams
+
+typedef unsigned long long Trigram;
+
+/// Add the trigrams of a string to out, compared case insensitively, like find_i
+void add_trigrams(const String& str, vector<Trigram>& out) {
+  Trigram a = 0, b = 0;
+  size_t i = 0;
+  for (wxUniChar c : str) {
+    Trigram lower = (Trigram)toLower(c) & 0x1FFFFF; // 21 bits per character
+    if (i >= 2) out.push_back(a << 42 | b << 21 | lower);
+    a = b;
+    b = lower;
+    ++i;
+  }
+}
+
+void sort_unique(vector<Trigram>& trigrams) {
+  sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+/// Is every object that matches query also matched by previous?
+bool refines(vector<QuickFilterPart> const& query, vector<QuickFilterPart> const& previous) {
+  for (auto const& old_part : previous) {
+    bool implied = false;
+    for (auto const& part : query) {
+      if (part.need_match != old_part.need_match) continue;
+      if (part.need_match) {
+        // a longer string in fewer fields
+        implied = find_i(part.type, old_part.type) != String::npos
+               && find_i(part.query, old_part.query) != String::npos;
+      } else {
+        // excluding a shorter string from more fields
+        implied = find_i(old_part.type, part.type) != String::npos
+               && find_i(old_part.query, part.query) != String::npos;
+      }
+      if (implied) break;
+    }
+    if (!implied) return false;
+  }
+  return true;
+}
+
+// ----------------------------------------------------------------------------- : SearchText
+
+/// Append a string to out, in lower case and encoded as UTF-8
+void append_lower_utf8(const String& str, std::string& out) {
+  String lower;
+  lower.reserve(str.size());
+  for (wxUniChar c : str) lower += toLower(c);
+  wxScopedCharBuffer utf8 = lower.ToUTF8();
+  out.append(utf8.data(), utf8.length());
+}
+
+/// Does the range [begin,end) contain needle?
+/** memchr skips to the places where the first byte of the needle occurs, and is vectorized by the C library */
+bool contains_bytes(const char* begin, const char* end, std::string const& needle) {
+  size_t n = needle.size();
+  if (n == 0) return true;
+  while ((size_t)(end - begin) >= n) {
+    const char* p = (const char*)memchr(begin, needle[0], end - begin - n + 1);
+    if (!p) return false;
+    if (memcmp(p + 1, needle.data() + 1, n - 1) == 0) return true;
+    begin = p + 1;
+  }
+  return false;
+}
+
+SearchText::Query::Query(QuickFilterPart const& part)
+  : type(part.type)
+  , need_match(part.need_match)
+{
+  append_lower_utf8(part.query, needle);
+}
+
+void SearchText::clear() {
+  text.clear();
+  fields.clear();
+}
+
+void SearchText::add(const String& name, const String& value) {
+  if (!fields.empty()) text += '\0';
+  append_lower_utf8(value, text);
+  fields.emplace_back(&name, text.size());
+}
+
+bool SearchText::matches(vector<Query> const& query) const {
+  for (auto const& part : query) {
+    if (contains(part) != part.need_match) return false;
+  }
+  return true;
+}
+
+bool SearchText::contains(Query const& part) const {
+  const char* data = text.data();
+  if (part.type.empty()) {
+    return contains_bytes(data, data + text.size(), part.needle);
+  }
+  size_t begin = 0;
+  for (auto const& f : fields) {
+    if (find_i(*f.first, part.type) != String::npos && contains_bytes(data + begin, data + f.second, part.needle)) {
+      return true;
+    }
+    begin = f.second + 1;
+  }
+  return false;
+}
+
+// ----------------------------------------------------------------------------- : CardSearchIndex
+
+CardSearchIndex::CardSearchIndex(Set& set)
+  : set(set)
+  , cards_changed(true), all_dirty(false)
+  , last_valid(false)
+{
+  set.actions.addListener(this);
+}
+
+CardSearchIndex::~CardSearchIndex() {
+  set.actions.removeListener(this);
+}
+
+void CardSearchIndex::find(vector<QuickFilterPart> const& query, vector<VoidP>& out) {
+  update();
+  // the trigrams that a card must contain
+  vector<Trigram> needed;
+  for (auto const& part : query) {
+    if (part.need_match) add_trigrams(part.query, needed);
+  }
+  sort_unique(needed);
+  vector<SearchText::Query> prepared(query.begin(), query.end());
+  // start with the smallest list of candidates
+  vector<const Card*> const* candidates = nullptr;
+  if (last_valid && refines(query, last_query)) {
+    candidates = &last_result;
+  }
+  static const vector<const Card*> none;
+  for (Trigram t : needed) {
+    auto it = postings.find(t);
+    if (it == postings.end()) {
+      candidates = &none;
+      break;
+    } else if (!candidates || it->second.size() < candidates->size()) {
+      candidates = &it->second;
+    }
+  }
+  // check the candidates
+  unordered_set<const Card*> found;
+  auto check = [&](const Card* card, const Entry& entry) {
+    for (Trigram t : needed) {
+      if (!binary_search(entry.trigrams.begin(), entry.trigrams.end(), t)) return;
+    }
+    if (entry.text.matches(prepared)) found.insert(card);
+  };
+  if (candidates) {
+    for (const Card* card : *candidates) {
+      check(card, entries.at(card));
+    }
+  } else {
+    for (auto const& e : entries) {
+      check(e.first, e.second);
+    }
+  }
+  // in the order of the set
+  last_result.clear();
+  FOR_EACH(card, set.cards) {
+    if (found.count(card.get())) {
+      out.push_back(card);
+      last_result.push_back(card.get());
+    }
+  }
+  last_query = query;
+  last_valid = true;
+}
+
+void CardSearchIndex::update() {
+  if (all_dirty) {
+    entries.clear();
+    postings.clear();
+    all_dirty = false;
+    cards_changed = true;
+  }
+  if (cards_changed) {
+    // add new cards, and remove cards that are no longer in the set
+    unordered_set<const Card*> in_set;
+    FOR_EACH(card, set.cards) {
+      in_set.insert(card.get());
+      Entry& entry = entries[card.get()];
+      if (!entry.card) entry.card = card;
+    }
+    for (auto it = entries.begin() ; it != entries.end() ; ) {
+      if (in_set.count(it->first)) {
+        ++it;
+      } else {
+        unindex(it->second);
+        it = entries.erase(it);
+      }
+    }
+    cards_changed = false;
+  }
+  for (auto& e : entries) {
+    if (e.second.dirty) index(*e.first, e.second);
+  }
+}
+
+void CardSearchIndex::index(const Card& card, Entry& entry) {
+  static const String notes_name = _("notes");
+  unindex(entry);
+  FOR_EACH_CONST(v, card.data) {
+    String str = v->toString();
+    add_trigrams(str, entry.trigrams);
+    entry.text.add(v->fieldP->name, str);
+  }
+  add_trigrams(card.notes, entry.trigrams);
+  entry.text.add(notes_name, card.notes);
+  sort_unique(entry.trigrams);
+  for (Trigram t : entry.trigrams) {
+    postings[t].push_back(&card);
+  }
+  entry.dirty = false;
+}
+
+void CardSearchIndex::unindex(Entry& entry) {
+  for (Trigram t : entry.trigrams) {
+    auto it = postings.find(t);
+    if (it == postings.end()) continue;
+    vector<const Card*>& cards = it->second;
+    auto pos = std::find(cards.begin(), cards.end(), entry.card.get());
+    if (pos != cards.end()) {
+      *pos = cards.back();
+      cards.pop_back();
+    }
+    if (cards.empty()) postings.erase(it);
+  }
+  entry.trigrams.clear();
+  entry.text.clear();
+  entry.dirty = true;
+}
+
+void CardSearchIndex::changed(const Card* card) {
+  auto it = entries.find(card);
+  if (it != entries.end()) it->second.dirty = true;
+}
+
+void CardSearchIndex::onAction(const Action& action, bool undone) {
+  TYPE_CASE_(action, DisplayChangeAction) {
+    return; // doesn't change the text of cards
+  }
+  last_valid = false;
+  TYPE_CASE(action, ValueAction) {
+    if (action.card) {
+      changed(action.card.get());
+    } else if (FakeTextValue* value = dynamic_cast<FakeTextValue*>(action.valueP.get())) {
+      // the notes of a card, or a keyword
+      FOR_EACH(card, set.cards) {
+        if (value->underlying == &card->notes) changed(card.get());
+      }
+    } else if (!set.data.contains(action.valueP)) {
+      all_dirty = true; // we don't know what changed
+    }
+    return;
+  }
+  TYPE_CASE(action, ScriptValueEvent) {
+    if (action.card) changed(action.card);
+    return;
+  }
+  TYPE_CASE(action, ReplaceAllAction) {
+    FOR_EACH_CONST(a, action.actions) {
+      if (a.card) changed(a.card.get());
+      else        all_dirty = true;
+    }
+    return;
+  }
+  TYPE_CASE_(action, CardListAction) {
+    cards_changed = true;
+    return;
+  }
+  TYPE_CASE_(action, KeywordListAction) {
+    return; // cards that use the keywords are updated by scripts
+  }
+  TYPE_CASE_(action, ChangeKeywordModeAction) {
+    return;
+  }
+  TYPE_CASE_(action, PackTypesAction) {
+    return;
+  }
+  all_dirty = true;
+}
+
+// ----------------------------------------------------------------------------- : CardQuickFilter
+
+CardQuickFilter::CardQuickFilter(const SetP& set, String const& query)
+  : QuickFilter<Card>(query)
+  , set(set)
+{}
+
+void CardQuickFilter::getItems(vector<CardP> const& in, vector<VoidP>& out) const {
+  if (&in == &set->cards) {
+    set->searchIndex().find(query, out);
+  } else {
+    QuickFilter<Card>::getItems(in, out);
+  }
+}
@@ -0,0 +1,113 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <util/action_stack.hpp>
+#include <data/filter.hpp>
+
+DECLARE_POINTER_TYPE(Card);
+DECLARE_POINTER_TYPE(Set);
+
+// ----------------------------------------------------------------------------- : SearchText
+
+/// The text of all fields of a card in lower case, for matching quick search queries without converting values
+/** The text is stored as UTF-8, so it can be searched with memchr and memcmp.
+ *  The fields are separated by null characters, so a match can't span two fields.
+ */
+class SearchText {
+public:
+  /// A part of a quick search query, prepared for matching
+  struct Query {
+    Query(QuickFilterPart const& part);
+    String      type;
+    std::string needle; ///< Lower case UTF-8 query string
+    bool        need_match;
+  };
+
+  void clear();
+  /// Add the text of a field, the name should stay alive as long as this object
+  void add(const String& name, const String& text);
+  /// Does the text match all parts of the query? Gives the same result as match_quicksearch_query
+  bool matches(vector<Query> const& query) const;
+
+private:
+  std::string text;
+  vector<pair<const String*,size_t>> fields; ///< Name and end of each field in the text
+
+  bool contains(Query const& part) const;
+};
+
+// ----------------------------------------------------------------------------- : CardSearchIndex
+
+/// An index of the text on the cards of a set, for the quick search box
+/** For each card the index stores the (lower case) trigrams that occur in its field values and notes.
+ *  A card can only contain a string if it contains all trigrams of that string,
+ *  so a query is answered by intersecting the posting lists of the trigrams in the query,
+ *  and then checking only the remaining candidates against the SearchText of the card.
+ *
+ *  The index listens to the actions on the set, cards that are changed are marked as dirty,
+ *  and indexed again on the next search.
+ *
+ *  When a query refines the previous one (for example because the user typed another letter),
+ *  the previous result is narrowed down instead of searching all cards again.
+ *
+ *  Should only be used from the main thread.
+ */
+class CardSearchIndex : public ActionListener {
+public:
+  CardSearchIndex(Set& set);
+  ~CardSearchIndex();
+
+  /// Find the cards that match a quick search query, in the order of set.cards
+  void find(vector<QuickFilterPart> const& query, vector<VoidP>& out);
+
+protected:
+  void onAction(const Action& action, bool undone) override;
+
+private:
+  typedef unsigned long long Trigram;
+
+  struct Entry {
+    CardP card;               ///< Keeps the card alive, so its address is not reused while it is in the index
+    vector<Trigram> trigrams; ///< Sorted trigrams of the card
+    SearchText text;          ///< Lower case text of the card
+    bool dirty = true;        ///< Should the card be indexed again?
+  };
+
+  Set& set;
+  unordered_map<const Card*, Entry> entries;
+  unordered_map<Trigram, vector<const Card*>> postings; ///< Cards containing each trigram
+  bool cards_changed;  ///< Cards may have been added or removed
+  bool all_dirty;      ///< All cards should be indexed again
+
+  vector<QuickFilterPart> last_query;  ///< The previous query
+  vector<const Card*>     last_result; ///< Cards that matched last_query
+  bool last_valid;                     ///< Is last_result still up to date?
+
+  /// Make the index up to date with the cards in the set
+  void update();
+  /// (Re)index a single card
+  void index(const Card& card, Entry& entry);
+  /// Remove a card from the posting lists
+  void unindex(Entry& entry);
+  /// Mark a card as changed
+  void changed(const Card* card);
+};
+
+// ----------------------------------------------------------------------------- : CardQuickFilter
+
+/// A quick search filter for the cards of a set, that uses the CardSearchIndex of the set
+class CardQuickFilter : public QuickFilter<Card> {
+public:
+  CardQuickFilter(const SetP& set, String const& query);
+  void getItems(vector<CardP> const& in, vector<VoidP>& out) const override;
+private:
+  SetP set;
+};
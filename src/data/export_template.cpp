@@ -12,6 +12,8 @@
 #include <data/set.hpp>
 #include <data/field.hpp>
 #include <util/io/package_manager.hpp>
+#include <data/format/image_writer.hpp>
+#include <wx/wfstream.h>
 
 // ----------------------------------------------------------------------------- : Export template, basics
 
@@ -53,3 +55,11 @@ IMPLEMENT_REFLECTION(ExportTemplate) {
 IMPLEMENT_DYNAMIC_ARG(ExportInfo*, export_info, nullptr);
 
 ExportInfo::ExportInfo() : allow_writes_outside(false) {}
+
+ExportInfo::~ExportInfo() {}
+
+void ExportInfo::finish() {
+  // close the text files first, writing the images can fail
+  text_files.clear();
+  if (image_writer) image_writer->finish();
+}
@@ -18,6 +18,8 @@ DECLARE_POINTER_TYPE(Field);
 DECLARE_POINTER_TYPE(Style);
 DECLARE_POINTER_TYPE(ExportTemplate);
 DECLARE_POINTER_TYPE(Package);
+class ImageWriterPool;
+class wxFileOutputStream;
 
 // ----------------------------------------------------------------------------- : ExportTemplate
 
@@ -48,6 +50,7 @@ private:
 /// Information that can be used by export functions
 struct ExportInfo {
   ExportInfo();
+  ~ExportInfo();
   
   SetP               set;                ///< The set that is being exported
   PackageP           export_template;    ///< The export template used
@@ -57,6 +60,12 @@ struct ExportInfo {
   String             directory_absolute; ///< The absolute path of the directory
   map<String,wxSize> exported_images;     ///< Images (from symbol font) already exported, and their size
   bool               allow_writes_outside; ///< Can files outside the directory be written to?
+  unique_ptr<ImageWriterPool> image_writer; ///< Writes the images of write_image_file in the background (optional)
+  map<String,unique_ptr<wxFileOutputStream>> text_files; ///< Files written by write_text_file, only those written with append are kept open
+  
+  /// Close the text files, and wait until all images are written
+  /** Throws an Error if some of the images could not be written */
+  void finish();
 };
 
 DECLARE_DYNAMIC_ARG(ExportInfo*, export_info);
@@ -119,6 +119,22 @@ wxFont Font::toWxFont(double scale) const {
   return font;
 }
 
+const wxFont& Font::toWxFont(double scale, String& metrics_key) const {
+  if (scaled.scale != scale || scaled.size != size() || scaled.flags != flags || scaled.underline != underline()
+      || scaled.name != name() || scaled.italic_name != italic_name()) {
+    scaled.scale       = scale;
+    scaled.size        = size();
+    scaled.flags       = flags;
+    scaled.underline   = underline();
+    scaled.name        = name();
+    scaled.italic_name = italic_name();
+    scaled.font        = toWxFont(scale);
+    scaled.key         = scaled.font.GetNativeFontInfoDesc();
+  }
+  metrics_key = scaled.key;
+  return scaled.font;
+}
+
 IMPLEMENT_REFLECTION_NO_SCRIPT(Font) {
   REFLECT(name);
   REFLECT(size);
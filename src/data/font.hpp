@@ -64,9 +64,25 @@ public:
   
   /// Convert this font to a wxFont
   wxFont toWxFont(double scale) const;
+  /// Convert this font to a wxFont, and get a key that identifies it for the TextExtentCache
+  /** The key is made from the face, size, weight and style of the wxFont.
+   *  The result of the last call is remembered, since text layout asks for the same scale many times in a row.
+   */
+  const wxFont& toWxFont(double scale, String& metrics_key) const;
   
 private:
   DECLARE_REFLECTION();
+  
+  /// The last result of toWxFont, and the properties it was made from
+  struct Scaled {
+    double scale = -1, size = 0;
+    int    flags = 0;
+    bool   underline = false;
+    String name, italic_name;
+    wxFont font;
+    String key;
+  };
+  mutable Scaled scaled;
 };
 
 
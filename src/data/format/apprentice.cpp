@@ -16,46 +16,13 @@
 #include <data/field/choice.hpp>
 #include <util/tagged_string.hpp>
 #include <util/window_id.hpp>
-#include <wx/progdlg.h>
+#include <gui/export_progress_dialog.hpp>
 #include <wx/wfstream.h>
 #include <wx/datstrm.h>
 #include <wx/filename.h>
 
 String card_rarity_code(const String& rarity);
 
-// ----------------------------------------------------------------------------- : Generic export dialog
-
-/// Callback for updating a progress bar
-class WithProgress {
-public:
-  virtual void onProgress(float progress, const String& message) = 0;
-  virtual ~WithProgress () {}
-};
-
-/// Exception thrown to indicate exporting should be aborted
-class AbortException {};
-
-/// A dialog to show the progress of exporting
-class ExportProgressDialog : public wxProgressDialog, public WithProgress {
-public:
-  ExportProgressDialog(Window* parent, const String& title, const String& message);
-  
-  /// Update the progress bar
-  /** if the operation should be aborted, throws an AbortException
-   */
-  void onProgress(float progress, const String& message) override;
-};
-
-ExportProgressDialog::ExportProgressDialog(Window* parent, const String& title, const String& message)
-  : wxProgressDialog(title, message, 1000, parent, wxPD_APP_MODAL | wxPD_SMOOTH | wxPD_CAN_ABORT)
-{}
-
-void ExportProgressDialog::onProgress(float progress, const String& message) {
-  if (!Update(int(progress * 1000), message)) {
-    throw AbortException();
-  }
-}
-
 // ----------------------------------------------------------------------------- : Generic apprentice database
 
 /// An Apprentice database file, has read() and write() functions
@@ -13,6 +13,7 @@
 #include <data/settings.hpp>
 
 class Game;
+struct PackSimulation;
 DECLARE_POINTER_TYPE(Set);
 DECLARE_POINTER_TYPE(Card);
 
@@ -86,18 +87,44 @@ FileFormatP mse1_file_format();
 FileFormatP mse2_file_format();
 FileFormatP mtg_editor_file_format();
 
+// ----------------------------------------------------------------------------- : Progress
+
+/// Callback for updating a progress bar
+class WithProgress {
+public:
+  virtual void onProgress(float progress, const String& message) = 0;
+  virtual ~WithProgress () {}
+};
+
+/// Exception thrown to indicate exporting should be aborted
+class AbortException {};
+
 // ----------------------------------------------------------------------------- : Other ways to export
 
 /// Export images for each card in a set to a list of files
 void export_images(Window* parent, const SetP& set);
 
 /// Export the image for each card in a list of cards
+/** The cards are rendered on the main thread, encoding and writing the image files is done by background threads.
+ *  If a progress_target is given it is updated for each card, it can cancel the export by throwing an AbortException.
+ */
 void export_images(const SetP& set, const vector<CardP>& cards,
-                   const String& path, const String& filename_template, FilenameConflicts conflicts);
+                   const String& path, const String& filename_template, FilenameConflicts conflicts,
+                   WithProgress* progress_target = nullptr);
+
+/// Export the image for each card in a set, the filename template can include a directory
+/** The directory is created if needed, existing files are overwritten.
+ *  If the filename template is empty, the one from the game settings is used.
+ */
+void export_images(const SetP& set, const String& filename_template, WithProgress* progress_target = nullptr);
 
 /// Export the image of a single card
 void export_image(const SetP& set, const CardP& card, const String& filename);
 
+/// Generate an image of a card, for example to write it to a file
+Image export_image(const SetP& set, const CardP& card);
+Image export_image(const SetP& set, const CardP& card, const double zoom, const Radians angle_radians);
+
 /// Generate a bitmap image of a card
 Bitmap export_bitmap(const SetP& set, const CardP& card);
 Bitmap export_bitmap(const SetP& set, const CardP& card, const double zoom, const Radians angle_radians);
@@ -107,3 +134,9 @@ void export_mws(Window* parent, const SetP& set);
 
 /// Export a set to Apprentice
 void export_apprentice(Window* parent, const SetP& set);
+
+/// Count the cards in a set for each statistics category of its game, as CSV or JSON
+String export_statistics(const SetP& set, bool json);
+
+/// The number of copies of each card in simulated packs, as CSV
+String export_pack_simulation(const SetP& set, const PackSimulation& simulation);
@@ -9,17 +9,20 @@
 #include <util/prec.hpp>
 #include <util/tagged_string.hpp>
 #include <data/format/formats.hpp>
+#include <data/format/image_writer.hpp>
 #include <data/set.hpp>
 #include <data/card.hpp>
 #include <data/stylesheet.hpp>
 #include <data/settings.hpp>
 #include <render/card/viewer.hpp>
 #include <wx/filename.h>
+#include <wx/thread.h>
+#include <deque>
 
 // ----------------------------------------------------------------------------- : Single card export
 
 void export_image(const SetP& set, const CardP& card, const String& filename) {
-  Image img = export_bitmap(set, card).ConvertToImage();
+  Image img = export_image(set, card);
   img.SaveFile(filename);  // can't use Bitmap::saveFile, it wants to know the file type
               // but image.saveFile determines it automagicly
 }
@@ -100,18 +103,121 @@ Bitmap export_bitmap(const SetP& set, const CardP& card, const double zoom, cons
   return bitmap;
 }
 
-// ----------------------------------------------------------------------------- : Multiple card export
+Image export_image(const SetP& set, const CardP& card) {
+  return export_bitmap(set, card).ConvertToImage();
+}
+
+Image export_image(const SetP& set, const CardP& card, const double zoom, const Radians angle) {
+  return export_bitmap(set, card, zoom, angle).ConvertToImage();
+}
+
+// ----------------------------------------------------------------------------- : Image writer
 
+class ImageWriterPool::Worker : public wxThread {
+public:
+  Worker(ImageWriterPool& pool) : wxThread(wxTHREAD_JOINABLE), pool(pool) {}
+  ExitCode Entry() override;
+private:
+  ImageWriterPool& pool;
+};
+
+wxThread::ExitCode ImageWriterPool::Worker::Entry() {
+  while (true) {
+    unique_ptr<ImageExportJob> job;
+    {
+      wxMutexLocker lock(pool.mutex);
+      while (pool.queue.empty() && !pool.done) {
+        pool.job_added.Wait();
+      }
+      if (pool.queue.empty()) return 0; // done
+      job = move(pool.queue.front());
+      pool.queue.pop_front();
+      pool.job_taken.Signal();
+    }
+    // can't use Bitmap::saveFile, it wants to know the file type
+    // but image.saveFile determines it automagicly
+    if (!job->image.SaveFile(job->filename)) {
+      wxMutexLocker lock(pool.mutex);
+      pool.failed.push_back(job->filename);
+    }
+  }
+}
+
+ImageWriterPool::ImageWriterPool(size_t thread_count)
+  : job_added(mutex), job_taken(mutex)
+  , max_queue(2 * thread_count)
+  , done(false)
+{
+  for (size_t i = 0 ; i < thread_count ; ++i) {
+    Worker* worker = new Worker(*this);
+    if (worker->Run() != wxTHREAD_NO_ERROR) {
+      delete worker;
+      break;
+    }
+    workers.push_back(worker);
+  }
+}
+
+ImageWriterPool::~ImageWriterPool() {
+  {
+    wxMutexLocker lock(mutex);
+    queue.clear();
+  }
+  stop();
+}
+
+void ImageWriterPool::add(unique_ptr<ImageExportJob> job) {
+  if (workers.empty()) {
+    // no threads, write it ourselfs
+    if (!job->image.SaveFile(job->filename)) {
+      failed.push_back(job->filename);
+    }
+    return;
+  }
+  wxMutexLocker lock(mutex);
+  while (queue.size() >= max_queue) {
+    job_taken.Wait();
+  }
+  queue.push_back(move(job));
+  job_added.Signal();
+}
+
+void ImageWriterPool::finish() {
+  stop();
+  if (!failed.empty()) {
+    String message = _("Unable to write image files:");
+    FOR_EACH(filename, failed) message += _("\n") + filename;
+    failed.clear();
+    throw Error(message);
+  }
+}
+
+void ImageWriterPool::stop() {
+  {
+    wxMutexLocker lock(mutex);
+    done = true;
+    job_added.Broadcast();
+  }
+  FOR_EACH(worker, workers) {
+    worker->Wait();
+    delete worker;
+  }
+  workers.clear();
+}
+
+// ----------------------------------------------------------------------------- : Multiple card export
 
 void export_images(const SetP& set, const vector<CardP>& cards,
-                   const String& path, const String& filename_template, FilenameConflicts conflicts)
+                   const String& path, const String& filename_template, FilenameConflicts conflicts,
+                   WithProgress* progress_target)
 {
   wxBusyCursor busy;
   // Script
   ScriptP filename_script = parse(filename_template, nullptr, true);
   // Path
   wxFileName fn(path);
-  // Export
+  // Determine filenames
+  vector<pair<CardP,String>> todo;
   std::set<String> used; // for CONFLICT_NUMBER_OVERWRITE
   FOR_EACH_CONST(card, cards) {
     // filename for this card
@@ -122,9 +228,39 @@ void export_images(const SetP& set, const vector<CardP>& cards,
     fn.SetFullName(filename);
     // does the file exist?
     if (!resolve_filename_conflicts(fn, conflicts, used)) continue;
-    // write image
     filename = fn.GetFullPath();
     used.insert(filename);
-    export_image(set, card, filename);
+    todo.push_back(make_pair(card, filename));
+  }
+  // Render the cards, while other threads write the images
+  ImageWriterPool writer(max(1, wxThread::GetCPUCount() - 1));
+  for (size_t i = 0 ; i < todo.size() ; ++i) {
+    if (progress_target) {
+      progress_target->onProgress(float(i) / todo.size(), todo[i].second);
+    }
+    auto job = make_unique<ImageExportJob>();
+    job->image    = export_image(set, todo[i].first);
+    job->filename = todo[i].second;
+    writer.add(move(job));
+  }
+  writer.finish();
+  if (progress_target) {
+    progress_target->onProgress(1.0f, _(""));
+  }
+}
+
+void export_images(const SetP& set, const String& filename_template, WithProgress* progress_target) {
+  String out = !filename_template.empty()
+    ? filename_template
+    : settings.gameSettingsFor(*set->game).images_export_filename;
+  // split off the path
+  String path = _(".");
+  size_t pos = out.find_last_of(_("/\\"));
+  if (pos != String::npos) {
+    path = out.substr(0, pos);
+    if (!wxDirExists(path)) wxMkdir(path);
+    path += _("/x");
+    out = out.substr(pos + 1);
   }
+  export_images(set, set->cards, path, out, CONFLICT_NUMBER_OVERWRITE, progress_target);
 }
@@ -0,0 +1,54 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <wx/thread.h>
+#include <deque>
+
+// ----------------------------------------------------------------------------- : Image writer
+
+/// An image that is waiting to be written to a file
+struct ImageExportJob {
+  Image  image;
+  String filename;
+};
+
+/// Writes images to files using a number of background threads.
+/** Rendering has to happen on the main thread, since neither the dc nor the script context are thread safe,
+ *  but encoding and writing the image files can be done in parallel with it.
+ *
+ *  Jobs are passed around by unique_ptr, so an Image is never shared between threads
+ *  (the reference counting of wxImage is not thread safe).
+ */
+class ImageWriterPool {
+public:
+  ImageWriterPool(size_t thread_count);
+  /// Stops the workers, images that are still queued are not written
+  ~ImageWriterPool();
+  
+  /// Queue an image for writing, blocks while the queue is full
+  void add(unique_ptr<ImageExportJob> job);
+  /// Wait until all queued images are written
+  /** Throws an Error if some of the images could not be written */
+  void finish();
+  
+private:
+  class Worker;
+  wxMutex     mutex;
+  wxCondition job_added;   ///< Signaled when a job is added, or when we are done
+  wxCondition job_taken;   ///< Signaled when a worker takes a job from the queue
+  deque<unique_ptr<ImageExportJob>> queue;
+  size_t max_queue;        ///< Maximum number of images waiting, to bound memory use
+  bool   done;             ///< No more jobs will be added
+  vector<Worker*> workers;
+  vector<String> failed;   ///< Files that could not be written
+  
+  void stop();
+};
@@ -0,0 +1,137 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <data/format/formats.hpp>
+#include <data/game.hpp>
+#include <data/set.hpp>
+#include <data/card.hpp>
+#include <data/pack.hpp>
+#include <data/statistics.hpp>
+#include <data/graph_data.hpp>
+
+// ----------------------------------------------------------------------------- : Utilities
+
+/// Quote a cell of a CSV file if needed
+static String csv_cell(const String& str) {
+  if (str.find_first_of(_(",\"\r\n")) == String::npos) return str;
+  return _("\"") + replace_all(str, _("\""), _("\"\"")) + _("\"");
+}
+
+/// A JSON string literal
+static String json_string(const String& str) {
+  String ret = _("\"");
+  for (wxUniChar c : str) {
+    if      (c == _('"'))  ret += _("\\\"");
+    else if (c == _('\\')) ret += _("\\\\");
+    else if (c == _('\n')) ret += _("\\n");
+    else if (c == _('\r')) ret += _("\\r");
+    else if (c == _('\t')) ret += _("\\t");
+    else if (c < 0x20)     ret += String::Format(_("\\u%04x"), (int)c);
+    else                   ret += c;
+  }
+  return ret + _("\"");
+}
+
+// ----------------------------------------------------------------------------- : Statistics
+
+String export_statistics(const SetP& set, bool json) {
+  Game& game = *set->game;
+  StatsTable& table = set->statsTable();
+  // the most dimensions of any category, for the csv header
+  size_t max_dims = 0;
+  FOR_EACH(cat, game.statistics_categories) {
+    cat->find_dimensions(game.statistics_dimensions);
+    max_dims = max(max_dims, cat->dimensions.size());
+  }
+  String out;
+  if (json) {
+    out += _("[");
+  } else {
+    out += _("category");
+    for (size_t j = 1 ; j <= max_dims ; ++j) {
+      out += String::Format(_(",value %d"), (int)j);
+    }
+    out += _(",count\n");
+  }
+  // each category, the values of a dimension are only determined once
+  bool first_cat = true;
+  FOR_EACH(cat, game.statistics_categories) {
+    // group the values the same way as the statistics panel does,
+    // elements outside the groups of a dimension are not shown there, so they are not counted
+    GraphDataPre pre;
+    table.graphData(cat->dimensions, pre);
+    GraphData data(pre);
+    map<vector<int>,UInt> group_counts; // sorted in the order of the groups
+    vector<int> key(data.axes.size());
+    FOR_EACH_CONST(v, data.values) {
+      bool shown = true;
+      for (size_t j = 0 ; j < key.size() ; ++j) {
+        key[j] = v->group_nrs[j];
+        if (key[j] < 0 || key[j] >= (int)data.axes[j]->groups.size()) shown = false;
+      }
+      if (shown) group_counts[key] += 1;
+    }
+    vector<pair<vector<String>,UInt>> counts;
+    FOR_EACH(c, group_counts) {
+      vector<String> values;
+      for (size_t j = 0 ; j < c.first.size() ; ++j) {
+        values.push_back(data.axes[j]->groups[c.first[j]].name);
+      }
+      counts.emplace_back(values, c.second);
+    }
+    if (json) {
+      out += first_cat ? _("\n  {") : _(",\n  {");
+      out += _("\"category\": ") + json_string(cat->name);
+      out += _(", \"dimensions\": [");
+      for (size_t j = 0 ; j < cat->dimensions.size() ; ++j) {
+        if (j > 0) out += _(", ");
+        out += json_string(cat->dimensions[j]->name);
+      }
+      out += _("], \"counts\": [");
+      bool first_count = true;
+      FOR_EACH(c, counts) {
+        out += first_count ? _("\n    {\"values\": [") : _(",\n    {\"values\": [");
+        for (size_t j = 0 ; j < c.first.size() ; ++j) {
+          if (j > 0) out += _(", ");
+          out += json_string(c.first[j]);
+        }
+        out += String::Format(_("], \"count\": %u}"), c.second);
+        first_count = false;
+      }
+      out += first_count ? _("]}") : _("\n  ]}");
+    } else {
+      FOR_EACH(c, counts) {
+        out += csv_cell(cat->name);
+        for (size_t j = 0 ; j < max_dims ; ++j) {
+          out += _(",");
+          if (j < c.first.size()) out += csv_cell(c.first[j]);
+        }
+        out += String::Format(_(",%u\n"), c.second);
+      }
+    }
+    first_cat = false;
+  }
+  if (json) {
+    out += first_cat ? _("]\n") : _("\n]\n");
+  }
+  return out;
+}
+
+// ----------------------------------------------------------------------------- : Pack simulation
+
+String export_pack_simulation(const SetP& set, const PackSimulation& simulation) {
+  String out = _("card,count,per pack\n");
+  for (size_t i = 0 ; i < set->cards.size() ; ++i) {
+    size_t count = simulation.card_counts.at(i);
+    double per_pack = simulation.packs ? (double)count / simulation.packs : 0;
+    out += csv_cell(set->cards[i]->identification());
+    out += String::Format(_(",%lu,%.6f\n"), (unsigned long)count, per_pack);
+  }
+  return out;
+}
@@ -0,0 +1,280 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <data/graph_data.hpp>
+#include <gfx/gfx.hpp>
+
+// ----------------------------------------------------------------------------- : GraphAxis
+
+void GraphAxis::addGroup(const String& name, UInt size) {
+  if (!groups.empty() && groups.back().name == name) {
+    groups.back().size += size;
+  } else {
+    groups.push_back(GraphGroup(name, size));
+  }
+  max = std::max(max, groups.back().size);
+  total += size;
+}
+
+// ----------------------------------------------------------------------------- : GraphData
+
+void GraphDataPre::splitList(size_t axis) {
+  // the parts of an element are placed directly after it, so the elements stay sorted by original_index
+  vector<GraphElementP> split;
+  split.reserve(elements.size());
+  vector<String> parts;
+  for (auto const& e : elements) {
+    parts.clear();
+    split_stats_list(e->values[axis], parts);
+    for (size_t i = 0 ; i + 1 < parts.size() ; ++i) {
+      GraphElementP e2(new GraphElement(*e));
+      e2->values[axis] = parts[i];
+      split.push_back(e2);
+    }
+    e->values[axis] = parts.back();
+    split.push_back(e);
+  }
+  swap(elements, split);
+}
+
+
+String to_bin(double value, double bin_size) {
+  if (bin_size <= 0 || value == 0) {
+    return String() << (int)value;
+  } else {
+    int bin = ceil(value / bin_size);
+    return String::Format(_("%.0f%c%.0f"), (bin-1) * bin_size + 1, EN_DASH, bin * bin_size);
+  }
+}
+int bin_to_group(double value, double bin_size) {
+  if (bin_size <= 0 || value == 0) {
+    return 0;
+  } else {
+    return ceil(value / bin_size);
+  }
+}
+
+GraphData::GraphData(const GraphDataPre& d)
+  : axes(d.axes)
+{
+  // The values on each axis are replaced by integer codes, one for each distinct value,
+  // so we only have to compare strings once per value, not once per element.
+  vector<vector<UInt>> element_codes(axes.size()); // for each axis, for each element: code
+  vector<vector<int>>  code_groups(axes.size());   // for each axis, for each code: group number
+  // find groups on each axis
+  size_t i = 0;
+  for (auto const& a : axes) {
+    unordered_map<String,UInt> codes;
+    vector<const String*> code_names;
+    vector<UInt> code_counts;
+    vector<UInt>& element_code = element_codes[i];
+    element_code.reserve(d.elements.size());
+    FOR_EACH_CONST(e, d.elements) {
+      assert(e->values.size() == axes.size());
+      auto it = codes.insert(make_pair(e->values[i], (UInt)code_names.size()));
+      if (it.second) {
+        code_names.push_back(&it.first->first);
+        code_counts.push_back(0);
+      }
+      code_counts[it.first->second] += 1;
+      element_code.push_back(it.first->second);
+    }
+    // distinct values in order, values that compare as equal are counted together
+    vector<UInt> sorted_codes(code_names.size());
+    for (UInt c = 0 ; c < sorted_codes.size() ; ++c) sorted_codes[c] = c;
+    stable_sort(sorted_codes.begin(), sorted_codes.end(), [&](UInt x, UInt y) { return smart_less(*code_names[x], *code_names[y]); });
+    vector<pair<String,UInt>> counts;
+    counts.reserve(sorted_codes.size());
+    for (UInt c : sorted_codes) {
+      if (!counts.empty() && !smart_less(counts.back().first, *code_names[c])) {
+        counts.back().second += code_counts[c];
+      } else {
+        counts.push_back(make_pair(*code_names[c], code_counts[c]));
+      }
+    }
+    if (a->numeric) {
+      // Add all values, calculate mean of the numeric ones
+      UInt numeric_count = 0;
+      int prev = 0;
+      FOR_EACH(c, counts) {
+        // numeric?
+        double d;
+        if (c.first.ToDouble(&d)) {
+          // update mean
+          a->mean_value += d * c.second;
+          a->max_value  = max(a->max_value, d);
+          numeric_count += c.second;
+          // add 0 bars before this value
+          int next = (int)floor(d);
+          for (int i = prev ; i < next ; i++) {
+            a->addGroup(to_bin(i, a->bin_size), 0);
+          }
+          prev = next + 1;
+          // add
+          if (a->bin_size) {
+            a->addGroup(to_bin(d, a->bin_size), c.second);
+          } else {
+            a->addGroup(c.first, c.second);
+          }
+        } else {
+          // non-numeric, add anyway
+          a->addGroup(c.first, c.second);
+        }
+      }
+      a->mean_value /= numeric_count;
+    } else if (a->order) {
+      // specific group order
+      FOR_EACH_CONST(gn, *a->order) {
+        auto it = lower_bound(counts.begin(), counts.end(), gn, [](const pair<String,UInt>& c, const String& n) { return smart_less(c.first, n); });
+        bool found = it != counts.end() && !smart_less(gn, it->first);
+        a->addGroup(gn, found ? it->second : 0);
+      }
+    } else {
+      FOR_EACH(c, counts) {
+        a->addGroup(c.first, c.second);
+      }
+    }
+    // colors
+    if (a->auto_color == AUTO_COLOR_NO && a->colors) {
+      // use colors from the table
+      FOR_EACH(g, a->groups) {
+        map<String,Color>::const_iterator it = a->colors->find(g.name);
+        if (it != a->colors->end()) {
+          g.color = it->second;
+        }
+      }
+    } else {
+      // find some nice colors for the groups
+      double step = 0;
+      bool first = true;
+      FOR_EACH(g, a->groups) {
+        double amount = a->auto_color == AUTO_COLOR_EVEN
+                          ? 1. / a->groups.size()
+                          : double(g.size) / a->total; // amount this group takes
+        if (!first) step += amount/2;
+        if (a->numeric) {
+          g.color = hsl2rgb(0.65 - 0.82 * step, 0.9 - 0.2 * fabs(step - 0.5), 0.3 + 0.35 * step);
+        } else {
+          g.color = hsl2rgb(0.6 + step, 0.9, 0.5);
+        }
+        step += amount / 2;
+        first = false;
+      }
+    }
+    // find the group for each distinct value
+    unordered_map<String,int> group_nrs;
+    for (int j = 0 ; j < (int)a->groups.size() ; ++j) {
+      group_nrs.insert(make_pair(a->groups[j].name, j)); // the first group with that name
+    }
+    code_groups[i].resize(code_names.size(), -1);
+    for (UInt c = 0 ; c < code_names.size() ; ++c) {
+      const String& v = *code_names[c];
+      double d;
+      if (a->numeric && a->bin_size > 0 && v.ToDouble(&d)) {
+        // calculate group that contains v
+        code_groups[i][c] = bin_to_group(d, a->bin_size);
+      } else {
+        // find group that contains v
+        auto it = group_nrs.find(v);
+        if (it != group_nrs.end()) code_groups[i][c] = it->second;
+      }
+    }
+    ++i;
+  }
+  // count elements in each position
+  values.reserve(d.elements.size());
+  size_t de_size = sizeof(GraphDataElement) + sizeof(int) * (axes.size() - 1);
+  for (size_t k = 0 ; k < d.elements.size() ; ++k) {
+    // make the group_nrs large enough
+    GraphDataElement* de = reinterpret_cast<GraphDataElement*>(new char[de_size]);
+    de->original_index = d.elements[k]->original_index;
+    for (size_t i = 0 ; i < axes.size() ; ++i) {
+      de->group_nrs[i] = code_groups[i][element_codes[i][k]];
+    }
+    values.push_back(de);
+  }
+}
+
+GraphData::~GraphData() {
+  FOR_EACH_CONST(v,values) delete v;
+}
+
+void GraphData::crossAxis(size_t axis1, size_t axis2, vector<UInt>& out) const {
+  size_t a1_size = axes[axis1]->groups.size();
+  size_t a2_size = axes[axis2]->groups.size();
+  out.clear();
+  out.resize(a1_size * a2_size, 0);
+  FOR_EACH_CONST(v, values) {
+    int v1 = v->group_nrs[axis1], v2 = v->group_nrs[axis2];
+    if (v1 >= 0 && v2 >= 0) {
+      out[a2_size * v1 + v2]++;
+    }
+  }
+}
+
+void GraphData::crossAxis(size_t axis1, size_t axis2, size_t axis3, vector<UInt>& out) const {
+  size_t a1_size = axes[axis1]->groups.size();
+  size_t a2_size = axes[axis2]->groups.size();
+  size_t a3_size = axes[axis3]->groups.size();
+  out.clear();
+  out.resize(a1_size * a2_size * a3_size, 0);
+  FOR_EACH_CONST(v, values) {
+    int v1 = v->group_nrs[axis1], v2 = v->group_nrs[axis2], v3 = v->group_nrs[axis3];
+    if (v1 >= 0 && v2 >= 0 && v3 >= 0) {
+      out[a3_size * (a2_size * v1 + v2) + v3]++;
+    }
+  }
+}
+
+bool matches(const GraphDataElement* v, const vector<int>& match) {
+  for (size_t i = 0 ; i < match.size() ; ++i) {
+    if (v->group_nrs[i] == -1 || (match[i] != -1 && v->group_nrs[i] != match[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+UInt GraphData::count(const vector<int>& match) const {
+  if (match.size() != axes.size()) return 0;
+  UInt count = 0;
+  size_t prev_index = (size_t)-1;
+  FOR_EACH_CONST(v, values) {
+    if (matches(v, match) && v->original_index != prev_index) {
+      prev_index = v->original_index; // don't count the same index twice
+      count += matches(v, match);
+    }
+  }
+  return count;
+}
+
+void GraphData::indices(const vector<int>& match, vector<size_t>& out) const {
+  if (match.size() != axes.size()) return;
+  size_t prev_index = (size_t)-1;
+  FOR_EACH_CONST(v, values) {
+    if (matches(v, match) && v->original_index != prev_index) {
+      prev_index = v->original_index; // don't select the same index twice
+      out.push_back(v->original_index);
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------- : Utilities
+
+void split_stats_list(const String& value, vector<String>& out) {
+  size_t start = 0;
+  size_t comma = value.find_first_of(_(','));
+  while (comma != String::npos) {
+    out.push_back(value.substr(start, comma - start));
+    if (is_substr(value, comma, _(", "))) ++comma; // skip space after it
+    start = comma + 1;
+    comma = value.find_first_of(_(','), start);
+  }
+  out.push_back(value.substr(start));
+}
@@ -9,10 +9,7 @@
 #include <util/prec.hpp>
 #include <data/keyword.hpp>
 #include <util/tagged_string.hpp>
-#include <unordered_map>
-#include <unordered_set>
 
-class KeywordTrie;
 DECLARE_POINTER_TYPE(KeywordParamValue);
 class Value;
 DECLARE_DYNAMIC_ARG(Value*, value_being_updated);
@@ -208,103 +205,137 @@ void Keyword::prepare(const vector<KeywordParamP>& param_types, bool force) {
   valid = !match_re.matches(_(""));
 }
 
-// ----------------------------------------------------------------------------- : KeywordTrie
+// ----------------------------------------------------------------------------- : KeywordMatcher
 
-namespace std {
-  template <> struct hash<wxUniChar> {
-    inline size_t operator () (wxUniChar x) const {
-      return std::hash<wxUniChar::value_type>()(x.GetValue());
+void KeywordMatcher::add(const String& literal, const Keyword& kw) {
+  size_t index = keywords.size();
+  keywords.push_back(&kw);
+  if (literal.empty()) {
+    always.push_back(index);
+    return;
+  }
+  if (trie_children.empty()) {
+    trie_children.resize(1);
+    trie_outputs.resize(1);
+  }
+  NodeId cur = 0;
+  for (wxUniChar c : literal) {
+    wxUniChar::value_type lc = toLower(c);
+    auto it = trie_children[cur].find(lc);
+    if (it == trie_children[cur].end()) {
+      NodeId next = (NodeId)trie_children.size();
+      trie_children[cur][lc] = next;
+      trie_children.emplace_back();
+      trie_outputs.emplace_back();
+      cur = next;
+    } else {
+      cur = it->second;
     }
-  };
-}
-
-/// A node in a trie to match keywords
-/* The trie is used to speed up matching, by quickly finding candidate keywords.
-*/
-class KeywordTrie {
-public:
-  KeywordTrie();
-  ~KeywordTrie();
-  
-  unordered_map<wxUniChar, unique_ptr<KeywordTrie>> children; ///< children after a given character
-  KeywordTrie* on_any_star; ///< children on /.*/ (owned or this)
-  vector<const Keyword*> finished; ///< keywords that end in this node
-  
-  /// Insert nodes representing the given character
-  /** return the node where the evaluation will be after matching the character */
-  KeywordTrie* insert(wxUniChar match);
-  /// Insert nodes representing the given string
-  /** return the node where the evaluation will be after matching the string */
-  KeywordTrie* insert(const String& match);
-
-  /// Insert nodes representing the regex /.*/
-  /** return the node where the evaluation will be after matching that regex */
-  KeywordTrie* insertAnyStar();
-};
-
-
-KeywordTrie::KeywordTrie()
-  : on_any_star(nullptr)
-{}
-KeywordTrie::~KeywordTrie() {
-  if (on_any_star != this) delete on_any_star;
+  }
+  trie_outputs[cur].push_back(index);
 }
 
-KeywordTrie* KeywordTrie::insert(wxUniChar c) {
-  #if USE_CASE_INSENSITIVE_KEYWORDS
-    c = toLower(c); // case insensitive matching
-  #endif
-  unique_ptr<KeywordTrie>& child = children[c];
-  if (!child) child.reset(new KeywordTrie);
-  return child.get();
-}
-KeywordTrie* KeywordTrie::insert(const String& match) {
-  KeywordTrie* cur = this;
-  for (wxUniChar c : match) {
-    cur = cur->insert(c);
+void KeywordMatcher::build() {
+  nodes.clear();
+  edges.clear();
+  outputs.clear();
+  if (trie_children.empty()) {
+    trie_children.resize(1);
+    trie_outputs.resize(1);
+  }
+  // flatten the trie, edges are already sorted because they come from a map
+  nodes.resize(trie_children.size());
+  for (size_t i = 0 ; i < nodes.size() ; ++i) {
+    Node& n = nodes[i];
+    n.edges_begin = edges.size();
+    FOR_EACH(c, trie_children[i]) edges.push_back(Edge{c.first, c.second});
+    n.edges_end = edges.size();
+    n.outputs_begin = outputs.size();
+    outputs.insert(outputs.end(), trie_outputs[i].begin(), trie_outputs[i].end());
+    n.outputs_end = outputs.size();
+    n.fail = n.dict = 0;
+  }
+  // fail and dictionary links, breadth first
+  vector<NodeId> queue;
+  for (size_t e = nodes[0].edges_begin ; e < nodes[0].edges_end ; ++e) {
+    queue.push_back(edges[e].target);
+  }
+  for (size_t q = 0 ; q < queue.size() ; ++q) {
+    NodeId parent = queue[q];
+    for (size_t e = nodes[parent].edges_begin ; e < nodes[parent].edges_end ; ++e) {
+      NodeId child = edges[e].target;
+      // longest suffix of (parent + c) that is in the trie
+      NodeId f = nodes[parent].fail, next = 0;
+      while (!step(f, edges[e].c, next) && f != 0) f = nodes[f].fail;
+      if (!step(f, edges[e].c, next) || next == child) next = 0;
+      nodes[child].fail = next;
+      nodes[child].dict = nodes[next].outputs_begin != nodes[next].outputs_end ? next : nodes[next].dict;
+      queue.push_back(child);
+    }
   }
-  return cur;
 }
 
-KeywordTrie* KeywordTrie::insertAnyStar() {
-  if (!on_any_star) on_any_star = new KeywordTrie();
-  on_any_star->on_any_star = on_any_star; // circular reference to itself
-  return on_any_star;
+void KeywordMatcher::candidates(const String& untagged, vector<const Keyword*>& out) const {
+  vector<bool> found(keywords.size(), false);
+  auto output = [&](size_t i) {
+    if (!found[i]) {
+      found[i] = true;
+      out.push_back(keywords[i]);
+    }
+  };
+  FOR_EACH_CONST(i, always) output(i);
+  if (nodes.size() <= 1) return;
+  NodeId state = 0;
+  for (wxUniChar c : untagged) {
+    wxUniChar::value_type lc = toLower(c);
+    NodeId next;
+    while (!step(state, lc, next)) {
+      if (state == 0) {
+        next = 0;
+        break;
+      }
+      state = nodes[state].fail;
+    }
+    state = next;
+    // report all literals that end here
+    for (NodeId n = state ; n != 0 ; n = nodes[n].dict) {
+      for (size_t o = nodes[n].outputs_begin ; o < nodes[n].outputs_end ; ++o) {
+        output(outputs[o]);
+      }
+    }
+  }
 }
 
-
 // ----------------------------------------------------------------------------- : KeywordDatabase
 
 IMPLEMENT_DYNAMIC_ARG(KeywordUsageStatistics*, keyword_usage_statistics, nullptr);
 
 KeywordDatabase::KeywordDatabase()
-  : root(nullptr)
+  : matcher(nullptr), matcher_built(false)
+  , hits(0), misses(0), forgotten(0)
 {}
-// Note: has to be here because in the header KeywordTrie is not defined
 KeywordDatabase::~KeywordDatabase() {}
 
 void KeywordDatabase::clear() {
-  root.reset();
+  matcher.reset();
+  clearExpansions();
 }
 
 void KeywordDatabase::add(const vector<KeywordP>& kws) {
   FOR_EACH_CONST(kw, kws) {
-    add(*kw);
+    addToMatcher(*kw);
   }
 }
 
 void KeywordDatabase::add(const Keyword& kw) {
-  if (kw.match.empty() || !kw.valid) return; // can't handle empty keywords
-  // Create root
-  if (!root) {
-    root = make_unique<KeywordTrie>();
-    root->on_any_star = root.get();
-  }
-  KeywordTrie* cur = root->insertAnyStar();
-  // Add to trie
-  String text; // normal text
+  addToMatcher(kw);
+}
+
+// Find the longest piece of literal text between parameters of a keyword,
+// that is the piece that will give the fewest false candidates.
+String keyword_literal(const Keyword& kw) {
+  String text, literal;
   size_t param = 0;
-  bool only_star = true;
   for (size_t i = 0 ; i < kw.match.size() ;) {
     Char c = kw.match.GetChar(i);
     if (is_substr(kw.match, i, _("<atom-param"))) {
@@ -315,105 +346,40 @@ void KeywordDatabase::add(const Keyword& kw) {
         kw.parameters[param]->eat_separator_after(kw.match, i);
       }
       ++param;
-      // match anything
-      cur = cur->insert(text);
+      if (text.size() > literal.size()) literal = text;
       text.clear();
-      cur = cur->insertAnyStar();
-      // enough?
-      if (!only_star) {
-        // If we have matched anything specific, this is a good time to stop
-        // it doesn't really matter how long we go on, since the trie is only used
-        // as an optimization to not have to match lots of regexes.
-        // As an added bonus, we get a better behaviour of matching earlier keywords first.
-        break;
-      }
     } else {
       text += c;
       i++;
-      only_star = false;
     }
   }
-  cur = cur->insert(text);
-  // now cur is the trie after matching the keyword anywhere in the input text
-  cur->finished.push_back(&kw);
+  if (text.size() > literal.size()) literal = text;
+  return literal;
 }
 
-void KeywordDatabase::prepare_parameters(const vector<KeywordParamP>& ps, const vector<KeywordP>& kws) {
-  FOR_EACH_CONST(kw, kws) {
-    kw->prepare(ps);
-  }
+void KeywordDatabase::addToMatcher(const Keyword& kw) {
+  if (kw.match.empty() || !kw.valid) return; // can't handle empty keywords
+  if (!matcher) matcher = make_unique<KeywordMatcher>();
+  matcher->add(keyword_literal(kw), kw);
+  matcher_built = false;
 }
 
-#ifdef _DEBUG
-void dump(int i, const KeywordTrie* t) {
-  FOR_EACH(c, t->children) {
-    wxLogDebug(String(i, _(' ')) + c.first + _("     ") + String::Format(_("%p"), c.second.get()));
-    dump(i + 2, c.second.get());
-  }
-  if (t->on_any_star) {
-    wxLogDebug(String(i, _(' ')) + _(".*") + _("     ") + String::Format(_("%p"), t->on_any_star));
-    if (t->on_any_star != t) dump(i + 2, t->on_any_star);
+const KeywordMatcher& KeywordDatabase::builtMatcher() const {
+  wxMutexLocker lock(matcher_mutex);
+  if (!matcher_built) {
+    matcher->build();
+    matcher_built = true;
   }
+  return *matcher;
 }
-#endif
-
-// ----------------------------------------------------------------------------- : KeywordDatabase : matching
 
-// transitive closure of a state, follow all on_any_star links
-void closure(vector<const KeywordTrie*>& state) {
-  for (size_t j = 0 ; j < state.size() ; ++j) {
-    if (state[j]->on_any_star && state[j]->on_any_star != state[j]) {
-      state.push_back(state[j]->on_any_star);
-    }
-  }
-}
-
-void step_state(vector<const KeywordTrie*>& state, wxUniChar c) {
-  vector<const KeywordTrie*> next;
-  for(auto kt : state) {
-    auto it = kt->children.find(c);
-    if (it != kt->children.end()) {
-      next.push_back(it->second.get());
-    }
-    // TODO: on any star first or last?
-    if (kt->on_any_star) {
-      next.push_back(kt->on_any_star);
-    }
+void KeywordDatabase::prepare_parameters(const vector<KeywordParamP>& ps, const vector<KeywordP>& kws) {
+  FOR_EACH_CONST(kw, kws) {
+    kw->prepare(ps);
   }
-  swap(state,next);
 }
 
-// Collect possible matching keywords
-/* First step in matching is to run over the string, and use the trie to find keywords that *potentially* appear in it.
- */
-unordered_set<Keyword const*> possible_matches(String const& tagged_str, KeywordTrie const* trie_root) {
-  unordered_set<const Keyword*> possible_matches;
-  if (!trie_root) return possible_matches;
-
-  vector<const KeywordTrie*> state;
-  state.push_back(trie_root);
-
-  for (String::const_iterator it = tagged_str.begin(); it != tagged_str.end();) {
-    wxUniChar c = *it;
-    // tag?
-    if (c == '<') {
-      it = skip_tag(it, tagged_str.end());
-    } else {
-      ++it;
-      c = toLower(c); // case insensitive matching
-      // find 'next' trie node set matching c
-      step_state(state, c);
-      closure(state);
-      // matches
-      for (auto kt : state) {
-        for (auto kw : kt->finished) {
-          possible_matches.insert(kw);
-        }
-      }
-    }
-  }
-  return possible_matches;
-}
+// ----------------------------------------------------------------------------- : KeywordDatabase : matching
 
 struct KeywordMatch {
   Keyword const* keyword;
@@ -437,7 +403,7 @@ void keyword_matches(const String& untagged_str, const Keyword& keyword, vector<
     it = max(it+1, match[0].end());
   }
 }
-void keyword_matches(const String& untagged_str, unordered_set<Keyword const*> keywords, vector<KeywordMatch>& out) {
+void keyword_matches(const String& untagged_str, const vector<Keyword const*>& keywords, vector<KeywordMatch>& out) {
   for (auto keyword : keywords) {
     keyword_matches(untagged_str, *keyword, out);
   }
@@ -457,7 +423,7 @@ void sort_keyword_matches(vector<KeywordMatch>& matches) {
     return a.keyword->keyword < b.keyword->keyword;
   });
 }
-vector<KeywordMatch> keyword_matches(const String& untagged_str, unordered_set<Keyword const*> keywords) {
+vector<KeywordMatch> keyword_matches(const String& untagged_str, const vector<Keyword const*>& keywords) {
   vector<KeywordMatch> out;
   keyword_matches(untagged_str, keywords, out);
   sort_keyword_matches(out);
@@ -779,23 +745,117 @@ String KeywordDatabase::expand(const String& text, KeywordExpandOptions const& o
   // Clean up usage statistics
   remove_from_stats(options.stat, options.stat_key);
   
+  // Expanded the same text before?
+  if (options.stat_key) {
+    wxMutexLocker lock(expansions_mutex);
+    auto it = expansions.find(options.stat_key);
+    if (it != expansions.end()) {
+      const Expansion& e = it->second;
+      if (e.input == text && e.match_condition.get() == options.match_condition.get()
+                          && e.expand_default.get()  == options.expand_default.get()
+                          && e.combine_script.get()  == options.combine_script.get()) {
+        ++hits;
+        if (options.stat) {
+          FOR_EACH_CONST(kw, e.used) {
+            options.stat->emplace_back(options.stat_key, kw);
+          }
+        }
+        return e.result;
+      }
+    }
+    ++misses;
+  }
+  
   // Remove all old reminder texts
   String tagged = remove_keyword_tags(text);
 
   // any keywords in database?
-  if (!root) return tagged;
+  if (!matcher) return tagged;
 
   // Find potential matches
-  auto possible_matches = ::possible_matches(tagged, root.get());
+  String untagged = untag_no_escape(tagged);
+  vector<const Keyword*> candidates;
+  builtMatcher().candidates(untagged, candidates);
 
   // Refine
-  String untagged = untag_no_escape(tagged);
-  auto matches = keyword_matches(untagged, possible_matches);
+  auto matches = keyword_matches(untagged, candidates);
   
   // Expand
-  String result = expand_keywords(tagged, matches, options);
-  assert_tagged(result, false);
-  return result;
+  if (!options.stat_key) {
+    String result = expand_keywords(tagged, matches, options);
+    assert_tagged(result, false);
+    return result;
+  }
+  // Expand, keeping track of the keywords used, so they can be added to the statistics when the expansion is reused.
+  // Note: the mutex is not held here, the scripts might expand keywords themselves
+  KeywordUsageStatistics used;
+  KeywordExpandOptions recording = options;
+  recording.stat = &used;
+  Expansion e;
+  e.result = expand_keywords(tagged, matches, recording);
+  assert_tagged(e.result, false);
+  e.input    = text;
+  e.untagged = untagged;
+  e.match_condition = options.match_condition;
+  e.expand_default  = options.expand_default;
+  e.combine_script  = options.combine_script;
+  FOR_EACH_CONST(u, used) {
+    e.used.push_back(u.second);
+  }
+  if (options.stat) {
+    options.stat->insert(options.stat->end(), used.begin(), used.end());
+  }
+  wxMutexLocker lock(expansions_mutex);
+  return (expansions[options.stat_key] = move(e)).result;
+}
+
+size_t KeywordDatabase::countMatches(const String& text, size_t& candidate_count) const {
+  if (!matcher) return 0;
+  String untagged = untag_no_escape(remove_keyword_tags(text));
+  vector<const Keyword*> candidates;
+  builtMatcher().candidates(untagged, candidates);
+  candidate_count += candidates.size();
+  return keyword_matches(untagged, candidates).size();
+}
+
+// ----------------------------------------------------------------------------- : KeywordDatabase : cached expansions
+
+void KeywordDatabase::keywordChanged(const Keyword& kw, bool match_changed) {
+  if (match_changed) matcher.reset();
+  // A matcher for just this keyword tells us which texts it can match
+  KeywordMatcher changed;
+  if (!kw.match.empty() && kw.valid) {
+    changed.add(keyword_literal(kw), kw);
+    changed.build();
+  }
+  wxMutexLocker lock(expansions_mutex);
+  vector<const Keyword*> candidates;
+  for (auto it = expansions.begin() ; it != expansions.end() ;) {
+    const Expansion& e = it->second;
+    candidates.clear();
+    if (!changed.empty()) changed.candidates(e.untagged, candidates);
+    if (!candidates.empty() || find(e.used.begin(), e.used.end(), &kw) != e.used.end()) {
+      it = expansions.erase(it);
+      ++forgotten;
+    } else {
+      ++it;
+    }
+  }
+}
+
+void KeywordDatabase::forgetExpansion(const Value* value) {
+  wxMutexLocker lock(expansions_mutex);
+  expansions.erase(value);
+}
+
+void KeywordDatabase::clearExpansions() {
+  wxMutexLocker lock(expansions_mutex);
+  expansions.clear();
+}
+
+KeywordDatabase::ExpansionStats KeywordDatabase::expansionStats() const {
+  wxMutexLocker lock(expansions_mutex);
+  return ExpansionStats{expansions.size(), hits, misses, forgotten};
 }
 
 // ----------------------------------------------------------------------------- : KeywordParamValue
@@ -13,12 +13,12 @@
 #include <util/dynamic_arg.hpp>
 #include <util/regex.hpp>
 #include <data/filter.hpp>
+#include <wx/thread.h>
 
 DECLARE_POINTER_TYPE(KeywordParam);
 DECLARE_POINTER_TYPE(KeywordMode);
 DECLARE_POINTER_TYPE(Keyword);
 DECLARE_POINTER_TYPE(ParamReferenceType);
-class KeywordTrie;
 class Value;
 
 // ----------------------------------------------------------------------------- : Keyword parameters
@@ -129,6 +129,63 @@ inline String type_name(const vector<KeywordP>&) {
   return _TYPE_("keywords"); // not actually used, only for locale.pl script
 }
 
+// ----------------------------------------------------------------------------- : KeywordMatcher
+
+/// Aho-Corasick automaton to quickly find candidate keywords
+/** For each keyword we take a piece of literal text from its match string, which must appear in any text that it matches.
+ *  In a single pass over a text, the automaton finds all keywords whose literal appears in it.
+ *  Only those candidates are then matched with their regular expression.
+ *  Keywords without any literal text are always candidates.
+ *
+ *  Matching is case insensitive.
+ *  The nodes are stored in flat arrays, the edges out of each node are sorted by character.
+ */
+class KeywordMatcher {
+public:
+  /// Add a keyword with the given literal text, which may be empty
+  void add(const String& literal, const Keyword& kw);
+  /// Build the automaton, must be called after adding keywords
+  void build();
+  
+  inline bool empty() const { return keywords.empty(); }
+  
+  /// Find the keywords that can potentially match somewhere in the untagged text
+  void candidates(const String& untagged, vector<const Keyword*>& out) const;
+  
+private:
+  typedef unsigned int NodeId;
+  struct Edge {
+    wxUniChar::value_type c;
+    NodeId target;
+    inline bool operator < (const Edge& that) const { return c < that.c; }
+  };
+  struct Node {
+    size_t edges_begin, edges_end;     ///< Range in edges
+    size_t outputs_begin, outputs_end; ///< Range in outputs, keywords whose literal ends here
+    NodeId fail; ///< Node for the longest proper suffix that is in the trie
+    NodeId dict; ///< Nearest node along fail links with outputs, or 0 if there is none
+  };
+  vector<Node>   nodes;    ///< Node 0 is the root
+  vector<Edge>   edges;
+  vector<size_t> outputs;  ///< Indices into keywords
+  vector<size_t> always;   ///< Keywords without literal text
+  vector<const Keyword*> keywords;
+  
+  /// The trie before it is built
+  vector<map<wxUniChar::value_type,NodeId>> trie_children;
+  vector<vector<size_t>>                    trie_outputs;
+  
+  /// Follow the edge for c out of node, or return false
+  inline bool step(NodeId node, wxUniChar::value_type c, NodeId& out) const {
+    const Node& n = nodes[node];
+    auto begin = edges.begin() + n.edges_begin, end = edges.begin() + n.edges_end;
+    auto it = lower_bound(begin, end, Edge{c,0});
+    if (it == end || it->c != c) return false;
+    out = it->target;
+    return true;
+  }
+};
+
 // ----------------------------------------------------------------------------- : Using keywords
 
 /// Store keyword usage statistics here, using value_being_updated as the key
@@ -160,10 +217,21 @@ public:
   /// Prepare the parameters and match regex for a list of keywords
   static void prepare_parameters(const vector<KeywordParamP>&, const vector<KeywordP>&);
   
-  /// Clear the database
+  /// Clear the database, and all cached expansions
   void clear();
   /// Is the database empty?
-  inline bool empty() const { return !root; }
+  inline bool empty() const { return !matcher; }
+  
+  /// A keyword was added, removed or changed
+  /** Only the cached expansions of texts that used the keyword, or in which it could now match, are forgotten.
+   *  @param match_changed the match string changed, or the keyword was added or removed,
+   *                       the database must be filled again before the next expansion
+   */
+  void keywordChanged(const Keyword& kw, bool match_changed);
+  /// Forget the cached expansion for a value, because something its scripts can depend on changed
+  void forgetExpansion(const Value* value);
+  /// Forget all cached expansions, because something all scripts can depend on changed
+  void clearExpansions();
   
   /// Expand/update all keywords in the given string.
   /** @param options.expand_default script function indicating whether reminder text should be shown by default
@@ -174,8 +242,46 @@ public:
    */
   String expand(const String& text, const KeywordExpandOptions&) const;
   
+  /// Find the keywords in a text without expanding them, for benchmarks
+  /** Returns the number of matches, and adds the number of keywords whose regex had to be tried to candidates */
+  size_t countMatches(const String& text, size_t& candidates) const;
+  
+  /// Statistics about the use of the expansion cache
+  struct ExpansionStats {
+    size_t entries;     ///< Number of cached expansions
+    size_t hits;        ///< Number of expansions taken from the cache
+    size_t misses;      ///< Number of expansions that had to be done
+    size_t forgotten;   ///< Number of expansions forgotten because a keyword changed
+  };
+  ExpansionStats expansionStats() const;
+  
 private:
-  unique_ptr<KeywordTrie> root; ///< Data structure for finding keywords
+  unique_ptr<KeywordMatcher> matcher; ///< Data structure for finding candidate keywords
+  mutable bool               matcher_built; ///< Has the matcher been built since keywords were last added?
+  mutable wxMutex            matcher_mutex;
+  
+  /// The last expansion done for a value
+  /** Expansions are only reused when the input and the scripts are the same,
+   *  the rest of the context is handled by forgetting expansions when it changes.
+   */
+  struct Expansion {
+    String input;                       ///< Text before expansion
+    String untagged;                    ///< Untagged input without keyword tags, to find out whether a changed keyword can match
+    ScriptValueP match_condition;       ///< The scripts used, kept alive so another script can't get the same address
+    ScriptValueP expand_default;
+    ScriptValueP combine_script;
+    String result;                      ///< Text after expansion
+    vector<const Keyword*> used;        ///< Keywords that were expanded, for the usage statistics
+  };
+  mutable wxMutex expansions_mutex;
+  mutable unordered_map<const Value*, Expansion> expansions; ///< Indexed by value_being_updated
+  mutable size_t hits, misses, forgotten;
+  
+  /// Add a keyword to the matcher, without building it
+  void addToMatcher(const Keyword& kw);
+  /// The matcher, built first if keywords were added since it was last used
+  /** Building is delayed, because keywords are usually added in more than one list */
+  const KeywordMatcher& builtMatcher() const;
   
   /// (try to) expand a single keyword
   /** If the keyword matches:
@@ -11,7 +11,12 @@
 #include <data/set.hpp>
 #include <data/game.hpp>
 #include <data/card.hpp>
+#include <data/action/value.hpp>
+#include <data/action/set.hpp>
+#include <script/script.hpp>
 #include <queue>
+#include <atomic>
+#include <wx/thread.h>
 using boost::indeterminate;
 
 // ----------------------------------------------------------------------------- : PackType
@@ -98,6 +103,100 @@ bool PackItem::update(Context& ctx) {
 }
 
 
+// ----------------------------------------------------------------------------- : PackPools
+
+PackPools::PackPools(Set& set)
+  : set(set)
+{
+  set.actions.addListener(this);
+}
+
+PackPools::~PackPools() {
+  set.actions.removeListener(this);
+}
+
+const vector<CardP>& PackPools::cards(const PackType& type) {
+  static const vector<CardP> no_cards;
+  if (!type.filter) return no_cards;
+  Pool& pool = pools[type.filter.getScriptP()];
+  if (pool.age < all_changed || pool.keep.size() != set.cards.size()) {
+    // filter all cards
+    pool.keep.assign(set.cards.size(), false);
+    for (size_t i = 0 ; i < set.cards.size() ; ++i) {
+      Context& ctx = set.getContext(set.cards[i]);
+      pool.keep[i] = type.filter.invoke(ctx)->toBool();
+    }
+  } else {
+    // filter only the cards that changed since the last time
+    bool any_changed = false;
+    for (size_t i = 0 ; i < set.cards.size() ; ++i) {
+      auto it = changed_cards.find(set.cards[i].get());
+      if (it == changed_cards.end() || it->second < pool.age) continue;
+      Context& ctx = set.getContext(set.cards[i]);
+      pool.keep[i] = type.filter.invoke(ctx)->toBool();
+      any_changed = true;
+    }
+    if (!any_changed) return pool.cards;
+  }
+  pool.cards.clear();
+  for (size_t i = 0 ; i < set.cards.size() ; ++i) {
+    if (pool.keep[i]) pool.cards.push_back(set.cards[i]);
+  }
+  pool.age = Age();
+  forgetOldChanges();
+  return pool.cards;
+}
+
+void PackPools::forgetOldChanges() {
+  if (changed_cards.empty()) return;
+  Age oldest;
+  for (auto const& p : pools) {
+    // pools older than all_changed will filter all cards anyway
+    if (p.second.age < oldest && all_changed < p.second.age) oldest = p.second.age;
+  }
+  for (auto it = changed_cards.begin() ; it != changed_cards.end() ; ) {
+    if (it->second < oldest) it = changed_cards.erase(it);
+    else ++it;
+  }
+}
+
+void PackPools::onAction(const Action& action, bool undone) {
+  TYPE_CASE(action, ValueAction) {
+    if (action.card) changed_cards[action.card.get()] = Age();
+    else             all_changed = Age(); // a set value, or notes or keywords
+    return;
+  }
+  TYPE_CASE(action, ScriptValueEvent) {
+    if (action.card) changed_cards[action.card] = Age();
+    else             all_changed = Age();
+    return;
+  }
+  TYPE_CASE(action, ReplaceAllAction) {
+    FOR_EACH_CONST(a, action.actions) {
+      if (a.card) changed_cards[a.card.get()] = Age();
+      else        all_changed = Age();
+    }
+    return;
+  }
+  TYPE_CASE(action, ChangeCardStyleAction) {
+    changed_cards[action.card.get()] = Age();
+    return;
+  }
+  TYPE_CASE(action, ChangeCardHasStylingAction) {
+    changed_cards[action.card.get()] = Age();
+    return;
+  }
+  TYPE_CASE_(action, PackTypesAction) {
+    pools.clear(); // forget the filters of removed pack types
+    return;
+  }
+  TYPE_CASE_(action, DisplayChangeAction) {
+    return; // only changes how cards are shown
+  }
+  // the card list, keywords, stylesheets, and anything else we don't know about
+  all_changed = Age();
+}
+
 // ----------------------------------------------------------------------------- : PackInstance
 
 PackInstance::PackInstance(const PackType& pack_type, PackGenerator& parent)
@@ -109,13 +208,7 @@ PackInstance::PackInstance(const PackType& pack_type, PackGenerator& parent)
 {
   // Filter cards
   if (pack_type.filter) {
-    FOR_EACH(card, parent.set->cards) {
-      Context& ctx = parent.set->getContext(card);
-      bool keep = pack_type.filter.invoke(ctx)->toBool();
-      if (keep) {
-        cards.push_back(card);
-      }
-    }
+    cards = parent.set->packPools().cards(pack_type);
   }
   // Sum of weights
   if (pack_type.select == SELECT_FIRST) {
@@ -144,8 +237,22 @@ PackInstance::PackInstance(const PackType& pack_type, PackGenerator& parent)
   FOR_EACH_CONST(item, pack_type.items) {
     depth = max(depth, 1 + parent.get(item->name).depth);
   }
+  init_alias_table();
 }
 
+PackInstance::PackInstance(const PackInstance& that, PackGenerator& parent)
+  : pack_type(that.pack_type)
+  , parent(parent)
+  , depth(that.depth)
+  , cards(that.cards)
+  , total_weight(that.total_weight)
+  , requested_copies(0)
+  , card_copies(0)
+  , expected_copies(0)
+  , alias_probability(that.alias_probability)
+  , alias(that.alias)
+{}
+
 void PackInstance::expect_copy(double copies) {
   this->expected_copies += copies;
   // propagate
@@ -212,7 +319,7 @@ void weighted_equal_divide(vector<WeightedItem>& items, int total) {
   }
 }
 
-void PackInstance::generate(vector<CardP>* out) {
+void PackInstance::generate(PackOutput* out) {
   card_copies = 0;
   if (requested_copies == 0) return;
   if (pack_type.select == SELECT_ALL) {
@@ -239,7 +346,9 @@ void PackInstance::generate(vector<CardP>* out) {
       int rem = (int)requested_copies;
       while (rem > 0) {
         shuffle(cards.begin(), cards.end(), parent.gen);
-        out->insert(out->end(), cards.begin(), cards.begin() + min(rem, max_per_batch));
+        for (int i = 0 ; i < min(rem, max_per_batch) ; ++i) {
+          out->add(cards[i]);
+        }
         rem -= max_per_batch;
       }
     }
@@ -284,12 +393,12 @@ void PackInstance::generate(vector<CardP>* out) {
         int rem = new_card_copies % (int)cards.size();
         // some copies of all cards
         for (int i = 0 ; i < div ; ++i) {
-          out->insert(out->end(), cards.begin(), cards.end());
+          FOR_EACH_CONST(card, cards) out->add(card);
         }
         // pick the remainder at random
         for (int i = 0 ; i < rem ; ++i) {
           int nr = parent.gen() % cards.size();
-          out->push_back(cards.at(nr));
+          out->add(cards.at(nr));
         }
       }
     }
@@ -298,7 +407,9 @@ void PackInstance::generate(vector<CardP>* out) {
     if (!cards.empty()) {
       // there is a card, pick it
       card_copies += requested_copies;
-      if (out) out->insert(out->end(), requested_copies, cards.front());
+      if (out) {
+        for (size_t i = 0 ; i < requested_copies ; ++i) out->add(cards.front());
+      }
     } else {
       // pick first nonempty item
       FOR_EACH_CONST(item, pack_type.items) {
@@ -313,11 +424,11 @@ void PackInstance::generate(vector<CardP>* out) {
   requested_copies = 0;
 }
 
-void PackInstance::generate_all(vector<CardP>* out, size_t copies) {
+void PackInstance::generate_all(PackOutput* out, size_t copies) {
   card_copies += copies * cards.size();
   if (out) {
     for (size_t i = 0 ; i < copies ; ++i) {
-      out->insert(out->end(), cards.begin(), cards.end());
+      FOR_EACH_CONST(card, cards) out->add(card);
     }
   }
   // and all items
@@ -327,43 +438,103 @@ void PackInstance::generate_all(vector<CardP>* out, size_t copies) {
   }
 }
 
-void PackInstance::generate_one_random(vector<CardP>* out) {
-  double r = parent.gen() * total_weight / parent.gen.max();
-  if (r < cards.size()) {
+double PackInstance::item_weight(const PackItem& item) {
+  PackInstance& i = parent.get(item.name);
+  if (pack_type.select == SELECT_PROPORTIONAL || pack_type.select == SELECT_EQUAL_PROPORTIONAL) {
+    return item.weight * i.total_weight;
+  } else if (pack_type.select == SELECT_NONEMPTY || pack_type.select == SELECT_EQUAL_NONEMPTY) {
+    return i.total_weight > 0 ? (double)item.weight : 0;
+  } else {
+    return item.weight;
+  }
+}
+
+void PackInstance::init_alias_table() {
+  // weights of the entries, scaled so that the average is 1
+  size_t n = pack_type.items.size() + 1;
+  vector<double> weights;
+  double total = 0;
+  FOR_EACH_CONST(item, pack_type.items) {
+    weights.push_back(max(0.0, item_weight(*item)));
+    total += weights.back();
+  }
+  weights.push_back((double)cards.size());
+  total += weights.back();
+  alias_probability.assign(n, 0);
+  alias.assign(n, 0);
+  if (total <= 0) return;
+  vector<size_t> small, large;
+  for (size_t i = 0 ; i < n ; ++i) {
+    weights[i] *= n / total;
+    (weights[i] < 1 ? small : large).push_back(i);
+  }
+  // fill up each small entry with a part of a large one
+  while (!small.empty() && !large.empty()) {
+    size_t s = small.back(); small.pop_back();
+    size_t l = large.back();
+    alias_probability[s] = weights[s];
+    alias[s] = l;
+    weights[l] -= 1 - weights[s];
+    if (weights[l] < 1) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // the rest are full, up to rounding errors
+  FOR_EACH(i, large) alias_probability[i] = 1;
+  FOR_EACH(i, small) alias_probability[i] = 1;
+}
+
+void PackInstance::generate_one_random(PackOutput* out) {
+  if (total_weight <= 0) return;
+  // pick an entry of the alias table, and use the fraction to choose between it and its alias
+  size_t n = alias.size();
+  double r = parent.gen() * (double)n / ((double)parent.gen.max() + 1);
+  size_t entry = min((size_t)r, n - 1);
+  if (r - entry >= alias_probability[entry]) entry = alias[entry];
+  if (entry == pack_type.items.size()) {
     // pick a card
+    if (cards.empty()) return; // only because of rounding errors
     card_copies++;
     if (out) {
-      int i = (int)r;
-      out->push_back(cards[i]);
+      size_t i = (size_t)(parent.gen() * (double)cards.size() / ((double)parent.gen.max() + 1));
+      out->add(cards[min(i, cards.size() - 1)]);
     }
   } else {
     // pick an item
-    r -= cards.size();
-    FOR_EACH_CONST(item, pack_type.items) {
-      PackInstance& i = parent.get(item->name);
-      if (pack_type.select == SELECT_PROPORTIONAL || pack_type.select == SELECT_EQUAL_PROPORTIONAL) {
-        r -= item->weight * i.total_weight;
-      } else if (pack_type.select == SELECT_NONEMPTY || pack_type.select == SELECT_EQUAL_NONEMPTY) {
-        if (i.total_weight > 0) r -= item->weight;
-      } else {
-        r -= item->weight;
-      }
-      // have we reached the item we were looking for?
-      if (r < 0) {
-        i.request_copy(item->amount);
-        break;
-      }
-    }
+    const PackItem& item = *pack_type.items[entry];
+    parent.get(item.name).request_copy(item.amount);
   }
 }
 
 // ----------------------------------------------------------------------------- : PackGenerator
 
+PackGenerator::PackGenerator()
+  : max_depth(0)
+{}
+
+PackGenerator::PackGenerator(const PackGenerator& that, unsigned seed)
+  : set(that.set)
+  , gen(seed)
+  , max_depth(that.max_depth)
+{
+  map<const PackInstance*,PackInstance*> copies;
+  FOR_EACH_CONST(i, that.instances) {
+    PackInstanceP& instance = instances[i.first];
+    instance = make_intrusive<PackInstance>(*i.second, *this);
+    copies[i.second.get()] = instance.get();
+  }
+  FOR_EACH_CONST(i, that.generation_order) {
+    generation_order.push_back(copies.at(i));
+  }
+}
+
 void PackGenerator::reset(const SetP& set, int seed) {
   this->set = set;
   gen.seed((unsigned)seed);
   max_depth = 0;
   instances.clear();
+  generation_order.clear();
 }
 void PackGenerator::reset(int seed) {
   gen.seed((unsigned)seed);
@@ -396,8 +567,49 @@ PackInstance& PackGenerator::get(const PackTypeP& type) {
   return get(type->name);
 }
 
+void PackGenerator::instantiate_all() {
+  if (!set) return;
+  FOR_EACH_CONST(type, set->game->pack_types) get(type);
+  FOR_EACH_CONST(type, set->pack_types)       get(type);
+  // the same order as generate uses, game file order and then set file order
+  generation_order.clear();
+  for (int depth = max_depth ; depth >= 0 ; --depth) {
+    auto add = [&](const PackTypeP& type) {
+      PackInstance* i = &get(type);
+      if (i->get_depth() == depth && find(generation_order.begin(), generation_order.end(), i) == generation_order.end()) {
+        generation_order.push_back(i);
+      }
+    };
+    FOR_EACH_CONST(type, set->game->pack_types) add(type);
+    FOR_EACH_CONST(type, set->pack_types)       add(type);
+  }
+}
+
+/// Adds the generated cards to a vector
+class PackCardList : public PackOutput {
+public:
+  PackCardList(vector<CardP>& cards) : cards(cards) {}
+  void add(const CardP& card) override {
+    cards.push_back(card);
+  }
+private:
+  vector<CardP>& cards;
+};
+
 void PackGenerator::generate(vector<CardP>& out) {
+  PackCardList list(out);
+  generate(list);
+}
+
+void PackGenerator::generate(PackOutput& out) {
   if (!set) return;
+  if (!generation_order.empty()) {
+    // all instances are known, no need to look them up
+    FOR_EACH(i, generation_order) {
+      i->generate(&out);
+    }
+    return;
+  }
   // We generate from depth max_depth to 0
   // instances can refer to other instances of lower depth, and generate
   // can change the number of copies of those lower depth instances
@@ -430,3 +642,121 @@ void PackGenerator::update_card_counts() {
     }
   }
 }
+
+// ----------------------------------------------------------------------------- : Simulation
+
+/// Counts the generated cards, by their position in the set
+class PackCardCounter : public PackOutput {
+public:
+  PackCardCounter(const unordered_map<const Card*,size_t>& card_index, vector<size_t>& counts)
+    : card_index(card_index), counts(counts)
+  {}
+  void add(const CardP& card) override {
+    auto it = card_index.find(card.get());
+    if (it != card_index.end()) counts[it->second]++;
+  }
+private:
+  const unordered_map<const Card*,size_t>& card_index;
+  vector<size_t>& counts;
+};
+
+/// Number of packs in a batch of the simulation
+const size_t SIMULATION_BATCH_SIZE = 1024;
+
+/// Packs to simulate, shared by the worker threads
+class PackSimulator {
+public:
+  PackSimulator(const SetP& set, const String& pack_name, size_t packs, unsigned seed)
+    : pack_name(pack_name), packs(packs), seed(seed)
+    , batches((packs + SIMULATION_BATCH_SIZE - 1) / SIMULATION_BATCH_SIZE)
+    , next_batch(0)
+  {
+    prototype.reset(set, 0);
+    prototype.instantiate_all();
+    prototype.get(pack_name); // throws if there is no such pack type
+    for (size_t i = 0 ; i < set->cards.size() ; ++i) {
+      card_index.insert(make_pair(set->cards[i].get(), i));
+    }
+  }
+  
+  /// Generate batches until there are none left, add the cards to counts
+  void run(vector<size_t>& counts) {
+    PackCardCounter counter(card_index, counts);
+    for (size_t batch = next_batch++ ; batch < batches ; batch = next_batch++) {
+      // Every batch starts from a copy of the prototype,
+      // because 'no replace' packs depend on the order of the cards after earlier packs
+      seed_seq seq{seed, (unsigned)batch};
+      unsigned batch_seed;
+      seq.generate(&batch_seed, &batch_seed + 1);
+      PackGenerator generator(prototype, batch_seed);
+      PackInstance& instance = generator.get(pack_name);
+      size_t end = min(packs, (batch + 1) * SIMULATION_BATCH_SIZE);
+      for (size_t i = batch * SIMULATION_BATCH_SIZE ; i < end ; ++i) {
+        instance.request_copy();
+        generator.generate(counter);
+      }
+    }
+  }
+  
+  /// Like run, but catches errors, for use from a worker thread
+  void run_and_catch(vector<size_t>& counts) {
+    try {
+      run(counts);
+    } catch (const Error& e) {
+      wxMutexLocker lock(error_mutex);
+      if (error.empty()) error = e.what();
+      next_batch = batches; // stop the other workers
+    }
+  }
+  
+  String error; ///< Error from a worker thread
+  
+private:
+  PackGenerator prototype;
+  String pack_name;
+  unordered_map<const Card*,size_t> card_index;
+  size_t packs;
+  unsigned seed;
+  size_t batches;
+  atomic<size_t> next_batch;
+  wxMutex error_mutex;
+};
+
+class PackSimulatorWorker : public wxThread {
+public:
+  PackSimulatorWorker(PackSimulator& simulator, size_t card_count)
+    : wxThread(wxTHREAD_JOINABLE), simulator(simulator), counts(card_count, 0)
+  {}
+  ExitCode Entry() override {
+    simulator.run_and_catch(counts);
+    return 0;
+  }
+  PackSimulator& simulator;
+  vector<size_t> counts;
+};
+
+PackSimulation simulate_packs(const SetP& set, const String& pack_name, size_t packs, unsigned seed) {
+  PackSimulator simulator(set, pack_name, packs, seed);
+  PackSimulation result = {packs, vector<size_t>(set->cards.size(), 0)};
+  // start workers, this thread does its part of the work as well
+  vector<PackSimulatorWorker*> workers;
+  for (int i = 1 ; i < wxThread::GetCPUCount() ; ++i) {
+    PackSimulatorWorker* worker = new PackSimulatorWorker(simulator, set->cards.size());
+    if (worker->Run() != wxTHREAD_NO_ERROR) {
+      delete worker;
+      break;
+    }
+    workers.push_back(worker);
+  }
+  simulator.run_and_catch(result.card_counts);
+  // add up the counts
+  FOR_EACH(worker, workers) {
+    worker->Wait();
+    for (size_t i = 0 ; i < result.card_counts.size() ; ++i) {
+      result.card_counts[i] += worker->counts[i];
+    }
+    delete worker;
+  }
+  if (!simulator.error.empty()) throw Error(simulator.error);
+  return result;
+}
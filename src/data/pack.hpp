@@ -11,6 +11,8 @@
 #include <util/prec.hpp>
 #include <util/reflect.hpp>
 #include <script/scriptable.hpp>
+#include <util/action_stack.hpp>
+#include <util/age.hpp>
 #include <boost/logic/tribool.hpp>
 #include <random>
 using boost::tribool;
@@ -79,13 +81,57 @@ inline String type_name(const PackType&) {
   return _TYPE_("pack");
 }
 
+// ----------------------------------------------------------------------------- : PackPools
+
+/// The cards of a set that pass the filter of each pack type
+/** The filters are only evaluated when a pool is first needed.
+ *  The pools listen to the actions on the set, and remember when each card was changed.
+ *  When a pool is used again, only the filter for the cards that changed since then are evaluated again.
+ *
+ *  Should only be used from the main thread.
+ */
+class PackPools : public ActionListener {
+public:
+  PackPools(Set& set);
+  ~PackPools();
+  
+  /// The cards that pass the filter of a pack type, in the order of set.cards
+  const vector<CardP>& cards(const PackType& type);
+  
+protected:
+  void onAction(const Action& action, bool undone) override;
+  
+private:
+  struct Pool {
+    vector<int>   keep;     ///< For each card in the set, does it pass the filter? (note: vector<bool> is evil)
+    vector<CardP> cards;    ///< The cards that pass the filter
+    Age           age = 0;  ///< When the pool was last brought up to date
+  };
+  Set& set;
+  map<ScriptP, Pool> pools;   ///< Pool for each filter script
+  unordered_map<const Card*, Age> changed_cards; ///< When cards were last changed
+  Age all_changed;                               ///< When all pools became invalid
+  
+  /// Forget the changes that all pools already know about
+  void forgetOldChanges();
+};
+
 // ----------------------------------------------------------------------------- : Generating / counting
 
+/// Receives the cards that are generated
+class PackOutput {
+public:
+  virtual ~PackOutput() {}
+  virtual void add(const CardP& card) = 0;
+};
+
 // A PackType that is instantiated for a particular Set,
 // i.e. we now know the actual cards
 class PackInstance : public IntrusivePtrBase<PackInstance> {
 public:
   PackInstance(const PackType& pack_type, PackGenerator& parent);
+  /// Copy an instance for another generator, without the counts
+  PackInstance(const PackInstance& that, PackGenerator& parent);
   
   /// Expect to pick this many copies from this pack, updates expected_copies
   void expect_copy(double copies = 1);
@@ -97,7 +143,7 @@ public:
     * And also the copies of referenced items might be incremented
     *
     * Resets the count of this instance to 0 */
-  void generate(vector<CardP>* out);
+  void generate(PackOutput* out);
   
   inline int    get_depth()           const { return depth; }
   inline bool   has_cards()           const { return !cards.empty(); }
@@ -115,13 +161,29 @@ private:
   double          expected_copies;
   
   /// Generate some copies of all cards and items
-  void generate_all(vector<CardP>* out, size_t copies);
+  void generate_all(PackOutput* out, size_t copies);
   /// Generate one card/item chosen at random (using the select type)
-  void generate_one_random(vector<CardP>* out);
+  void generate_one_random(PackOutput* out);
+  
+  /// Relative probability of picking an item in generate_one_random
+  double item_weight(const PackItem& item);
+  
+  /// Alias table for generate_one_random, for sampling in constant time (Vose's alias method)
+  /** Entry i is for pack_type.items[i], the last entry is for picking one of the cards */
+  vector<double> alias_probability; ///< Probability of picking entry i itself, instead of its alias
+  vector<size_t> alias;
+  void init_alias_table();
 };
 
 class PackGenerator {
 public:
+  PackGenerator();
+  /// Copy a generator, with its own counts and random generator
+  /** All pack types must already be instantiated in that generator, see instantiate_all.
+   *  The copy doesn't have to run scripts, so it can be used from another thread.
+   */
+  PackGenerator(const PackGenerator& that, unsigned seed);
+  
   /// Reset the generator, possibly switching the set or reseeding
   void reset(const SetP& set, int seed);
   /// Reset the generator, but not the set
@@ -130,9 +192,12 @@ public:
   /// Find the PackInstance for the PackType with the given name
   PackInstance& get(const String& name);
   PackInstance& get(const PackTypeP& type);
+  /// Instantiate all pack types of the set and game, this determines the cards of each type
+  void instantiate_all();
   
   /// Generate all cards, resets copies
   void generate(vector<CardP>& out);
+  void generate(PackOutput& out);
   /// Update all card_copies counters, resets copies
   void update_card_counts();
   
@@ -142,6 +207,25 @@ public:
 private:
   /// Details for each PackType
   map<String,PackInstanceP> instances;
+  /// All instances in the order in which they are generated, only after instantiate_all
+  vector<PackInstance*> generation_order;
   int max_depth;
 };
 
+// ----------------------------------------------------------------------------- : Simulation
+
+/// The number of copies of each card in a large number of generated packs
+struct PackSimulation {
+  size_t         packs;        ///< Number of packs that were generated
+  vector<size_t> card_counts;  ///< For each card in set->cards, the number of copies in all packs together
+};
+
+/// Generate many packs of a pack type, and count the cards in them
+/** The cards of all pack types are determined once, on the calling thread (which should be the main thread),
+ *  after that the packs are generated by worker threads without running any scripts.
+ *
+ *  Packs are generated in batches, each batch with a random generator seeded from the seed and the batch number.
+ *  So the result only depends on the seed, not on the number of threads.
+ */
+PackSimulation simulate_packs(const SetP& set, const String& pack_name, size_t packs, unsigned seed);
+
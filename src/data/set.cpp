@@ -16,6 +16,8 @@
 #include <data/field.hpp>
 #include <data/field/text.hpp>    // for 0.2.7 fix
 #include <data/field/information.hpp>
+#include <data/card_search.hpp>
+#include <data/statistics.hpp>
 #include <util/tagged_string.hpp> // for 0.2.7 fix
 #include <util/order_cache.hpp>
 #include <util/delayed_index_maps.hpp>
@@ -28,12 +30,18 @@
 Set::Set()
   : vcs (make_intrusive<VCS>())
   , script_manager(new SetScriptManager(*this))
+  , search_index(new CardSearchIndex(*this))
+  , stats_table(new StatsTable(*this))
+  , pack_pools(new PackPools(*this))
 {}
 
 Set::Set(const GameP& game)
   : game(game)
   , vcs (make_intrusive<VCS>())
   , script_manager(new SetScriptManager(*this))
+  , search_index(new CardSearchIndex(*this))
+  , stats_table(new StatsTable(*this))
+  , pack_pools(new PackPools(*this))
 {
   data.init(game->set_fields);
 }
@@ -43,6 +51,9 @@ Set::Set(const StyleSheetP& stylesheet)
   , stylesheet(stylesheet)
   , vcs (make_intrusive<VCS>())
   , script_manager(new SetScriptManager(*this))
+  , search_index(new CardSearchIndex(*this))
+  , stats_table(new StatsTable(*this))
+  , pack_pools(new PackPools(*this))
 {
   data.init(game->set_fields);
 }
@@ -64,6 +75,12 @@ void Set::updateStyles(const CardP& card, bool only_content_dependent) {
 void Set::updateDelayed() {
   script_manager->updateDelayed();
 }
+void Set::updateWhenSpellChecked(Value* value) {
+  script_manager->updateWhenSpellChecked(value);
+}
+void Set::updateSpellChecked() {
+  script_manager->updateSpellChecked();
+}
 
 Context& Set::getContextForThumbnails() {
   assert(!wxThread::IsMain());
@@ -275,8 +292,15 @@ void reflect_set_info_get_member(GetMember& handler, const IndexMap<FieldP, Valu
 }
 
 int Set::positionOfCard(const CardP& card, const ScriptValueP& order_by, const ScriptValueP& filter) {
-  // TODO : Lock the map?
   assert(order_by);
+  return orderCacheFor(order_by, filter).find(card);
+}
+int Set::numberOfCards(const ScriptValueP& filter) {
+  if (!filter) return (int)cards.size();
+  return orderCacheFor(ScriptValueP(), filter).size();
+}
+
+OrderCache<CardP>& Set::orderCacheFor(const ScriptValueP& order_by, const ScriptValueP& filter) {
   OrderCacheP& order = order_cache[make_pair(order_by,filter)];
   if (!order) {
     // 1. make a list of the order value for each card
@@ -284,7 +308,7 @@ int Set::positionOfCard(const CardP& card, const ScriptValueP& order_by, const S
     vector<int>    keep;   if(filter) keep.reserve(cards.size());
     FOR_EACH_CONST(c, cards) {
       Context& ctx = getContext(c);
-      values.push_back(order_by->eval(ctx)->toString());
+      values.push_back(order_by ? order_by->eval(ctx)->toString() : String());
       if (filter) {
         keep.push_back(filter->eval(ctx)->toBool());
       }
@@ -295,26 +319,45 @@ int Set::positionOfCard(const CardP& card, const ScriptValueP& order_by, const S
     #endif
     // 3. initialize order cache
     order = make_intrusive<OrderCache<CardP>>(cards, values, filter ? &keep : nullptr);
-  }
-  return order->find(card);
-}
-int Set::numberOfCards(const ScriptValueP& filter) {
-  if (!filter) return (int)cards.size();
-  map<ScriptValueP,int>::const_iterator it = filter_cache.find(filter);
-  if (it !=filter_cache.end()) {
-    return it->second;
   } else {
-    int n = 0;
-    FOR_EACH_CONST(c, cards) {
-      if (filter->eval(getContext(c))->toBool()) ++n;
+    // only the cards that have changed have to be moved
+    vector<CardP> changed = order->takeInvalidated();
+    FOR_EACH_CONST(c, changed) {
+      Context& ctx = getContext(c);
+      String value = order_by ? order_by->eval(ctx)->toString() : String();
+      bool   keep  = !filter || filter->eval(ctx)->toBool();
+      order->update(c, value, keep);
     }
-    filter_cache.insert(make_pair(filter,n));
-    return n;
   }
+  return *order;
 }
+
 void Set::clearOrderCache() {
   order_cache.clear();
-  filter_cache.clear();
+}
+void Set::orderCacheChanged(const CardP& card) {
+  if (!card) {
+    clearOrderCache();
+    return;
+  }
+  FOR_EACH(order, order_cache) {
+    if (order.second) order.second->invalidate(card);
+  }
+}
+
+CardSearchIndex& Set::searchIndex() {
+  assert(wxThread::IsMain());
+  return *search_index;
+}
+
+StatsTable& Set::statsTable() {
+  assert(wxThread::IsMain());
+  return *stats_table;
+}
+
+PackPools& Set::packPools() {
+  assert(wxThread::IsMain());
+  return *pack_pools;
 }
 
 // ----------------------------------------------------------------------------- : SetView
@@ -26,6 +26,9 @@ DECLARE_POINTER_TYPE(Keyword);
 DECLARE_POINTER_TYPE(PackType);
 DECLARE_POINTER_TYPE(ScriptValue);
 class SetScriptManager;
+class CardSearchIndex;
+class StatsTable;
+class PackPools;
 class SetScriptContext;
 class Context;
 class Dependency;
@@ -71,6 +74,11 @@ public:
   void updateStyles(const CardP& card, bool only_content_dependent);
   /// Update scripts that were delayed
   void updateDelayed();
+  /// Update a value again when the words it contains have been spell checked in the background
+  void updateWhenSpellChecked(Value* value);
+  /// Update values of which the spelling has been checked in the background
+  /** Should be called when idle */
+  void updateSpellChecked();
   /// A context for performing scripts
   /** Should only be used from the thumbnail thread! */
   Context& getContextForThumbnails();
@@ -108,11 +116,25 @@ public:
   }
   
   /// Find the position of a card in this set, when the card list is sorted using the given cirterium
+  /** Should only be used from the main thread! */
   int positionOfCard(const CardP& card, const ScriptValueP& order_by, const ScriptValueP& filter);
   /// Find the number of cards that match the given filter
+  /** Should only be used from the main thread! */
   int numberOfCards(const ScriptValueP& filter);
   /// Clear the order_cache used by positionOfCard
   void clearOrderCache();
+  /// The values of a card have changed, so its position should be determined again
+  /** If card is null, something changed that can affect all cards, and the order_cache is cleared */
+  void orderCacheChanged(const CardP& card);
+  /// Index for searching the text of the cards
+  /** Should only be used from the main thread! */
+  CardSearchIndex& searchIndex();
+  /// Values of the statistics dimensions for the cards
+  /** Should only be used from the main thread! */
+  StatsTable& statsTable();
+  /// The cards that pass the filters of the pack types
+  /** Should only be used from the main thread! */
+  PackPools& packPools();
   
   String typeName() const override;
   Version fileVersion() const override;
@@ -133,9 +155,18 @@ private:
   unique_ptr<SetScriptManager> script_manager;
   /// Object for executing scripts from the thumbnail thread
   unique_ptr<SetScriptContext> thumbnail_script_context;
-  /// Cache of cards ordered by some criterion
+  /// Index of the text on the cards
+  /** Created together with the set, so it hears about actions before the views of the set do */
+  unique_ptr<CardSearchIndex> search_index;
+  /// Values of the statistics dimensions, also created together with the set
+  unique_ptr<StatsTable> stats_table;
+  /// Cards for each pack type, also created together with the set
+  unique_ptr<PackPools> pack_pools;
+  /// Cache of cards ordered by some criterion, and filtered.
+  /** Without an order_by criterion, only the number of cards that match the filter is used. */
   map<pair<ScriptValueP,ScriptValueP>,OrderCacheP> order_cache;
-  map<ScriptValueP,int>                            filter_cache;
+  /// The order_cache for a criterion, with up to date values of all cards
+  OrderCache<CardP>& orderCacheFor(const ScriptValueP& order_by, const ScriptValueP& filter);
 };
 
 inline String type_name(const Set&) {
@@ -177,6 +177,8 @@ Settings::Settings()
   , print_layout         (LAYOUT_NO_SPACE)
   , internal_scale       (1.0)
   , internal_image_extension(true)
+  , image_cache_size     (64)
+  , show_render_cache    (false)
   #if USE_OLD_STYLE_UPDATE_CHECKER
   , updates_url          (_("http://magicseteditor.sourceforge.net/updates"))
   #endif
@@ -267,6 +269,8 @@ IMPLEMENT_REFLECTION_NO_SCRIPT(Settings) {
   REFLECT(apprentice_location);
   REFLECT(internal_scale);
   REFLECT(internal_image_extension);
+  REFLECT(image_cache_size);
+  REFLECT(show_render_cache);
   #if USE_OLD_STYLE_UPDATE_CHECKER
     REFLECT(updates_url);
   #else
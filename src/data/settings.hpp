@@ -196,6 +196,8 @@ public:
   // --------------------------------------------------- : Internal settings
   double internal_scale;
   bool internal_image_extension;
+  UInt image_cache_size; ///< Memory budget for decoded package images, in megabytes
+  bool show_render_cache; ///< Mark viewers with the number of text layer hits and misses
 
   // --------------------------------------------------- : Update checking
   #if USE_OLD_STYLE_UPDATE_CHECKER
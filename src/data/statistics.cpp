@@ -10,6 +10,14 @@
 #include <data/statistics.hpp>
 #include <data/field.hpp>
 #include <data/field/choice.hpp>
+#include <data/field/text.hpp>
+#include <data/set.hpp>
+#include <data/card.hpp>
+#include <data/action/value.hpp>
+#include <data/action/set.hpp>
+#include <data/graph_data.hpp>
+#include <util/tagged_string.hpp>
+#include <util/error.hpp>
 
 extern ScriptValueP script_primary_choice;
 
@@ -133,3 +141,189 @@ IMPLEMENT_REFLECTION_ENUM(GraphType) {
   VALUE_N("scatter",     GRAPH_TYPE_SCATTER);
   VALUE_N("scatter pie", GRAPH_TYPE_SCATTER_PIE);
 }
+
+// ----------------------------------------------------------------------------- : Statistics table
+
+const UInt NOT_DETERMINED = (UInt)-2; // value has to be determined by running the script
+
+StatsTable::StatsTable(Set& set)
+  : set(set)
+  , rows_changed(true), all_dirty(false)
+{
+  set.actions.addListener(this);
+}
+
+StatsTable::~StatsTable() {
+  set.actions.removeListener(this);
+}
+
+const StatsTable::Column& StatsTable::column(const StatsDimension& dim) {
+  update();
+  Column& col = columns[&dim];
+  col.values.resize(rows.size(), NOT_DETERMINED);
+  for (size_t i = 0 ; i < rows.size() ; ++i) {
+    if (col.values[i] != NOT_DETERMINED) continue;
+    Context& ctx = set.getContext(rows[i]);
+    try {
+      String value = untag(dim.script.invoke(ctx)->toString());
+      auto id = col.ids.insert(make_pair(value, (UInt)col.strings.size()));
+      if (id.second) col.strings.push_back(value);
+      col.values[i] = id.first->second;
+    } catch (ScriptError const& e) {
+      handle_error(ScriptError(e.what() + _("\n  in script for statistics dimension '") + dim.name + _("'")));
+      col.values[i] = NO_VALUE;
+    }
+  }
+  return col;
+}
+
+void StatsTable::elements(const vector<StatsDimensionP>& dims, vector<StatsElement>& out) {
+  vector<const Column*> cols;
+  FOR_EACH_CONST(dim, dims) {
+    cols.push_back(&column(*dim));
+  }
+  for (size_t i = 0 ; i < rows.size() ; ++i) {
+    StatsElement e = {i};
+    bool show = true;
+    for (size_t j = 0 ; j < dims.size() ; ++j) {
+      UInt id = cols[j]->values[i];
+      if (id == NO_VALUE) {
+        // the script failed
+        show = false;
+        break;
+      }
+      const String& value = cols[j]->strings[id];
+      if (value.empty() && !dims[j]->show_empty) {
+        // don't show this element
+        show = false;
+        break;
+      }
+      e.values.push_back(value);
+    }
+    if (show) out.push_back(move(e));
+  }
+}
+
+void StatsTable::graphData(const vector<StatsDimensionP>& dims, GraphDataPre& d) {
+  // create axes
+  FOR_EACH_CONST(dim, dims) {
+    d.axes.push_back(make_intrusive<GraphAxis>(
+      dim->name,
+      dim->colors.empty() ? AUTO_COLOR_EVEN : AUTO_COLOR_NO,
+      dim->numeric,
+      dim->bin_size,
+      &dim->colors,
+      dim->groups.empty() ? nullptr : &dim->groups
+      )
+    );
+  }
+  // find values for each card, only values of changed cards are determined again
+  vector<StatsElement> elems;
+  elements(dims, elems);
+  for (auto& se : elems) {
+    GraphElementP e = make_intrusive<GraphElement>(se.card);
+    swap(e->values, se.values);
+    assert(e->values.size() == dims.size());
+    d.elements.push_back(e);
+  }
+  // split lists
+  size_t dim_id = 0;
+  FOR_EACH_CONST(dim, dims) {
+    if (dim->split_list) d.splitList(dim_id);
+    ++dim_id;
+  }
+}
+
+void StatsTable::update() {
+  if (all_dirty) {
+    columns.clear();
+    dirty_cards.clear();
+    all_dirty = false;
+  }
+  if (rows_changed) {
+    // keep the values of cards that are still in the set
+    unordered_map<const Card*, size_t> old_rows;
+    for (size_t i = 0 ; i < rows.size() ; ++i) {
+      old_rows[rows[i].get()] = i;
+    }
+    for (auto& c : columns) {
+      vector<UInt> values(set.cards.size(), NOT_DETERMINED);
+      for (size_t i = 0 ; i < set.cards.size() ; ++i) {
+        auto it = old_rows.find(set.cards[i].get());
+        if (it != old_rows.end() && it->second < c.second.values.size()) {
+          values[i] = c.second.values[it->second];
+        }
+      }
+      c.second.values.swap(values);
+    }
+    rows = set.cards;
+    rows_changed = false;
+  }
+  if (!dirty_cards.empty()) {
+    for (size_t i = 0 ; i < rows.size() ; ++i) {
+      if (!dirty_cards.count(rows[i].get())) continue;
+      for (auto& c : columns) {
+        if (i < c.second.values.size()) c.second.values[i] = NOT_DETERMINED;
+      }
+    }
+    dirty_cards.clear();
+  }
+}
+
+void StatsTable::onAction(const Action& action, bool undone) {
+  TYPE_CASE(action, ValueAction) {
+    if (action.card) {
+      dirty_cards.insert(action.card.get());
+    } else if (FakeTextValue* value = dynamic_cast<FakeTextValue*>(action.valueP.get())) {
+      // the notes of a card?
+      bool notes = false;
+      FOR_EACH(card, set.cards) {
+        if (value->underlying == &card->notes) {
+          dirty_cards.insert(card.get());
+          notes = true;
+        }
+      }
+      if (!notes) all_dirty = true; // a keyword
+    } else {
+      all_dirty = true; // a set value, the scripts can use those as well
+    }
+    return;
+  }
+  TYPE_CASE(action, ScriptValueEvent) {
+    if (action.card) dirty_cards.insert(action.card);
+    else             all_dirty = true;
+    return;
+  }
+  TYPE_CASE(action, ReplaceAllAction) {
+    FOR_EACH_CONST(a, action.actions) {
+      if (a.card) dirty_cards.insert(a.card.get());
+      else        all_dirty = true;
+    }
+    return;
+  }
+  TYPE_CASE_(action, CardListAction) {
+    rows_changed = true;
+    return;
+  }
+  TYPE_CASE(action, ChangeCardStyleAction) {
+    dirty_cards.insert(action.card.get());
+    return;
+  }
+  TYPE_CASE(action, ChangeCardHasStylingAction) {
+    dirty_cards.insert(action.card.get());
+    return;
+  }
+  TYPE_CASE_(action, ChangeSetStyleAction) {
+    all_dirty = true;
+    return;
+  }
+  TYPE_CASE_(action, DisplayChangeAction) {
+    return; // only changes how cards are shown
+  }
+  TYPE_CASE_(action, PackTypesAction) {
+    return;
+  }
+  // keywords, and anything else we don't know about
+  all_dirty = true;
+}
+
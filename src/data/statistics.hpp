@@ -13,8 +13,13 @@
 #include <data/graph_type.hpp>
 #include <data/localized_string.hpp>
 #include <script/scriptable.hpp>
+#include <util/action_stack.hpp>
+#include <unordered_set>
 
 class Field;
+class Set;
+class GraphDataPre;
+DECLARE_POINTER_TYPE(Card);
 DECLARE_POINTER_TYPE(StatsDimension);
 DECLARE_POINTER_TYPE(StatsCategory);
 
@@ -69,3 +74,60 @@ public:
   DECLARE_REFLECTION();
 };
 
+// ----------------------------------------------------------------------------- : Statistics table
+
+/// A card with its values on some statistics dimensions
+struct StatsElement {
+  size_t         card;    ///< Index of the card in set.cards
+  vector<String> values;  ///< Value for each dimension
+};
+
+/// The values of the statistics dimensions for the cards in a set
+/** Each dimension is a column, with the untagged value of its script for each card in set.cards.
+ *  The values are interned, a column stores an index into the list of distinct values.
+ *
+ *  Columns are determined when they are first needed.
+ *  The table listens to the actions on the set, and only the values of the cards that are changed
+ *  are determined again, so switching between dimensions and editing cards stays cheap.
+ *
+ *  Should only be used from the main thread.
+ */
+class StatsTable : public ActionListener {
+public:
+  StatsTable(Set& set);
+  ~StatsTable();
+  
+  static const UInt NO_VALUE = (UInt)-1; ///< The script gave an error for this card
+  
+  struct Column {
+    vector<String> strings; ///< Distinct values
+    vector<UInt>   values;  ///< For each card, index into strings or NO_VALUE
+    unordered_map<String,UInt> ids; ///< Inverse of strings
+  };
+  /// The column for a dimension, the values correspond to set.cards
+  const Column& column(const StatsDimension& dim);
+  
+  /// The values of the cards on some dimensions, as they are shown in the statistics panel
+  /** Cards for which a script fails, or that have an empty value on a dimension that doesn't show empty values,
+   *  are skipped. Lists are not split.
+   */
+  void elements(const vector<StatsDimensionP>& dims, vector<StatsElement>& out);
+  /// The data for a graph of some dimensions, as it is shown in the statistics panel
+  /** Lists are split on dimensions with split_list, the axes use the bin size, colors and group order of the dimensions. */
+  void graphData(const vector<StatsDimensionP>& dims, GraphDataPre& out);
+  
+protected:
+  void onAction(const Action& action, bool undone) override;
+  
+private:
+  Set& set;
+  vector<CardP> rows;   ///< The cards that the values in the columns belong to
+  unordered_map<const StatsDimension*, Column> columns;
+  unordered_set<const Card*> dirty_cards; ///< Cards of which the values should be determined again
+  bool rows_changed;    ///< Cards have been added, removed or moved
+  bool all_dirty;       ///< All values should be determined again
+  
+  /// Bring the rows in line with set.cards, and forget the values of dirty cards
+  void update();
+};
+
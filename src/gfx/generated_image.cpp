@@ -8,6 +8,7 @@
 
 #include <util/prec.hpp>
 #include <gfx/generated_image.hpp>
+#include <gfx/image_cache.hpp>
 #include <util/io/package.hpp>
 #include <util/error.hpp>
 #include <data/symbol.hpp>
@@ -414,10 +415,8 @@ Image PackagedImage::generate(const Options& opt) const {
   // TODO : use opt.width and opt.height?
   // open file from package
   if (!opt.package) throw ScriptError(_("Can only load images in a context where an image is expected"));
-  auto file_stream = opt.package->openIn(filename);
   Image img;
-  if (image_load_file(img, *file_stream)) {
-    if (img.HasMask()) img.InitAlpha(); // we can't handle masks
+  if (image_cache.load(img, *opt.package, filename)) {
     return img;
   } else {
     throw ScriptError(_("Unable to load image '") + filename + _("' from '" + opt.package->name() + _("'")));
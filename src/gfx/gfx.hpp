@@ -16,6 +16,7 @@
 #include <util/prec.hpp>
 #include <util/real_point.hpp>
 #include <util/angle.hpp>
+#include <util/dynamic_arg.hpp>
 #include <gfx/color.hpp>
 
 // ----------------------------------------------------------------------------- : Resampling
@@ -57,6 +58,47 @@ void draw_resampled_text(DC& dc, const RealPoint& pos, const RealRect& rect, dou
 // scaling factor to use when drawing resampled text
 extern const int text_scaling;
 
+/// Downsampled text drawn by a single ValueViewer
+/** Downsampling text is expensive, but most of the text on a card is the same as in the previous redraw.
+ *  So each viewer keeps the bitmaps of the text it drew, keyed by everything that goes into them:
+ *  the text, font, color, size, sub-pixel position, stretch and blur.
+ *  Changes to the value or style lead to different keys, and a different zoom or rotation clears the layer.
+ *
+ *  Bitmaps that were not used while drawing the viewer are dropped afterwards,
+ *  so the cache never holds more than what the viewer currently shows.
+ *  Only used from the main thread.
+ */
+class TextLayer {
+public:
+  TextLayer();
+
+  /// Start drawing the viewer with the given zoom and angle
+  void begin(double zoom, Radians angle);
+  /// Done drawing, forget the text that was not drawn
+  void end();
+  /// Forget all text
+  void clear();
+
+  /// Find a bitmap, or nullptr if we don't have it
+  const Bitmap* find(const String& key);
+  /// Store a bitmap
+  const Bitmap& add(const String& key, const Image& image);
+
+  size_t hits, misses;  ///< Lookups during the last draw
+
+private:
+  struct Entry {
+    Bitmap bitmap;
+    bool   used;
+  };
+  unordered_map<String,Entry> entries;
+  double  zoom;
+  Radians angle;
+};
+
+/// The layer that draw_resampled_text uses, if any
+DECLARE_DYNAMIC_ARG(TextLayer*, drawing_text_layer);
+
 // ----------------------------------------------------------------------------- : Image rotation
 
 /// Rotates an image counter clockwise
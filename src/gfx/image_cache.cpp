@@ -0,0 +1,113 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <gfx/image_cache.hpp>
+#include <util/io/package.hpp>
+#include <util/io/package_manager.hpp>
+#include <gui/util.hpp> // image_load_file
+
+// ----------------------------------------------------------------------------- : ImageCache
+
+ImageCache image_cache;
+
+ImageCache::ImageCache()
+  : bytes(0), budget(64 * 1024 * 1024)
+  , hits(0), misses(0), evictions(0)
+{}
+
+size_t image_memory_size(const Image& image) {
+  if (!image.Ok()) return 0;
+  size_t pixels = (size_t)image.GetWidth() * image.GetHeight();
+  return pixels * (image.HasAlpha() ? 4 : 3);
+}
+
+bool ImageCache::load(Image& image, Package& package, const String& filename) {
+  String file;
+  if (PackagedP p = package_manager.openPackageOf(dynamic_cast<Packaged*>(&package), filename, file)) {
+    // absolute name of a file in another package,
+    // cache it under that package, so all packages that refer to the file share the image
+    return load(image, *p, file);
+  }
+  String key = package.absoluteFilename() + _("\1") + filename;
+  DateTime modified = package.modificationTime(filename);
+  {
+    wxMutexLocker lock(mutex);
+    auto it = index.find(key);
+    if (it != index.end()) {
+      if (it->second->modified == modified) {
+        ++hits;
+        entries.splice(entries.begin(), entries, it->second); // most recently used
+        // Image data is reference counted, and neither the counting nor the data itself are safe to share
+        // between threads, or with a caller that modifies the pixels. So hand out a copy.
+        image = it->second->image.Copy();
+        return true;
+      } else {
+        // the file was changed
+        remove(it->second);
+      }
+    }
+    ++misses;
+  }
+  // decode outside the lock, so other threads can use the cache in the mean time
+  auto file_stream = package.openIn(filename);
+  Image img;
+  if (!image_load_file(img, *file_stream)) return false;
+  if (img.HasMask()) img.InitAlpha(); // we can't handle masks
+  {
+    wxMutexLocker lock(mutex);
+    add(key, modified, img.Copy());
+  }
+  image = img;
+  return true;
+}
+
+void ImageCache::add(const String& key, const DateTime& modified, const Image& image) {
+  size_t size = image_memory_size(image);
+  if (size > budget) return; // would evict everything else
+  auto it = index.find(key);
+  if (it != index.end()) {
+    // another thread loaded the same image
+    remove(it->second);
+  }
+  entries.push_front(Entry{key, modified, image, size});
+  index[key] = entries.begin();
+  bytes += size;
+  evict();
+}
+
+void ImageCache::remove(Entries::iterator it) {
+  bytes -= it->bytes;
+  index.erase(it->key);
+  entries.erase(it);
+}
+
+void ImageCache::evict() {
+  while (bytes > budget && !entries.empty()) {
+    remove(prev(entries.end()));
+    ++evictions;
+  }
+}
+
+void ImageCache::setBudget(size_t new_budget) {
+  wxMutexLocker lock(mutex);
+  budget = new_budget;
+  evict();
+}
+
+void ImageCache::clear() {
+  wxMutexLocker lock(mutex);
+  entries.clear();
+  index.clear();
+  bytes = 0;
+}
+
+ImageCache::Stats ImageCache::stats() {
+  wxMutexLocker lock(mutex);
+  return Stats{entries.size(), bytes, budget, hits, misses, evictions};
+}
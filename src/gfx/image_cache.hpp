@@ -0,0 +1,85 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <wx/thread.h>
+#include <list>
+
+class Package;
+
+// ----------------------------------------------------------------------------- : ImageCache
+
+/// A cache of images that were decoded from files in packages
+/** Templates use the same frames and masks for many cards and styles,
+ *  so we only decode each file once.
+ *
+ *  Entries are keyed by package, filename and modification time of the file.
+ *  Absolute references to files in other packages ("/package/file") are keyed by the package that contains the file.
+ *  When the total size of the images exceeds the memory budget,
+ *  the least recently used images are evicted.
+ *
+ *  The cache is shared by the card viewers, the thumbnail thread and the exporters,
+ *  so all access is protected by a mutex.
+ */
+class ImageCache {
+public:
+  ImageCache();
+
+  /// Load an image from a package, or take it from the cache.
+  /** Returns false if the image could not be loaded.
+   *  The returned image is a private copy, so it can be modified by the caller.
+   */
+  bool load(Image& image, Package& package, const String& filename);
+
+  /// Change the memory budget, evicts images if needed
+  void setBudget(size_t bytes);
+  /// Remove all images from the cache
+  void clear();
+
+  /// Statistics about the use of the cache
+  struct Stats {
+    size_t entries;    ///< Number of images in the cache
+    size_t bytes;      ///< Memory used by those images
+    size_t budget;     ///< Maximum memory to use
+    size_t hits;       ///< Number of lookups that found the image
+    size_t misses;     ///< Number of lookups that had to decode the image
+    size_t evictions;  ///< Number of images evicted because of the budget
+  };
+  Stats stats();
+
+private:
+  struct Entry {
+    String   key;
+    DateTime modified;
+    Image    image;
+    size_t   bytes;
+  };
+  typedef list<Entry> Entries;
+
+  wxMutex mutex;
+  Entries entries;  ///< Most recently used entries first
+  unordered_map<String,Entries::iterator> index;
+  size_t bytes, budget;
+  size_t hits, misses, evictions;
+
+  /// Add an image, the mutex must be locked
+  void add(const String& key, const DateTime& modified, const Image& image);
+  /// Remove an entry, the mutex must be locked
+  void remove(Entries::iterator it);
+  /// Evict entries until we are within the budget, the mutex must be locked
+  void evict();
+};
+
+/// Memory used by an image
+size_t image_memory_size(const Image& image);
+
+/// The global image cache
+extern ImageCache image_cache;
+
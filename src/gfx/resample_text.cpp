@@ -175,6 +175,20 @@ void draw_resampled_text(DC& dc, const RealPoint& pos, const RealRect& rect, dou
       yi = static_cast<int>(rect.y) - blur_radius / text_scaling;
   int xsub = static_cast<int>(text_scaling * (pos.x - xi)),
       ysub = static_cast<int>(text_scaling * (pos.y - yi));
+  // have we drawn this text before?
+  TextLayer* layer = drawing_text_layer();
+  String key;
+  if (layer) {
+    key << text << _('\1') << dc.GetFont().GetNativeFontInfoDesc()
+        << _('\1') << color.packed << _('\1') << w << _('x') << h << _('+') << xsub << _(',') << ysub
+        << _('\1') << angle << _('\1') << stretch << _('\1') << blur_radius;
+    if (const Bitmap* bmp = layer->find(key)) {
+      for (int i = 0 ; i < repeat ; ++i) {
+        dc.DrawBitmap(*bmp, xi, yi);
+      }
+      return;
+    }
+  }
   // draw text
   Bitmap buffer(w * text_scaling, h * text_scaling, 24); // should be initialized to black
   wxMemoryDC mdc;
@@ -202,8 +216,62 @@ void draw_resampled_text(DC& dc, const RealPoint& pos, const RealRect& rect, dou
     blur_image_alpha(img_small);
   }
   // step 3. draw to dc
-  for (int i = 0 ; i < repeat ; ++i) {
-    dc.DrawBitmap(img_small, xi, yi);
+  if (layer) {
+    const Bitmap& bmp = layer->add(key, img_small);
+    for (int i = 0 ; i < repeat ; ++i) {
+      dc.DrawBitmap(bmp, xi, yi);
+    }
+  } else {
+    for (int i = 0 ; i < repeat ; ++i) {
+      dc.DrawBitmap(img_small, xi, yi);
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------- : TextLayer
+
+IMPLEMENT_DYNAMIC_ARG(TextLayer*, drawing_text_layer, nullptr);
+
+TextLayer::TextLayer()
+  : hits(0), misses(0), zoom(0), angle(0)
+{}
+
+void TextLayer::begin(double zoom, Radians angle) {
+  if (this->zoom != zoom || this->angle != angle) {
+    clear();
+    this->zoom  = zoom;
+    this->angle = angle;
+  }
+  hits = misses = 0;
+  FOR_EACH(e, entries) e.second.used = false;
+}
+
+void TextLayer::end() {
+  for (auto it = entries.begin() ; it != entries.end() ; ) {
+    if (it->second.used) ++it;
+    else it = entries.erase(it);
   }
 }
 
+void TextLayer::clear() {
+  entries.clear();
+}
+
+const Bitmap* TextLayer::find(const String& key) {
+  auto it = entries.find(key);
+  if (it == entries.end()) {
+    ++misses;
+    return nullptr;
+  }
+  ++hits;
+  it->second.used = true;
+  return &it->second.bitmap;
+}
+
+const Bitmap& TextLayer::add(const String& key, const Image& image) {
+  Entry& e = entries[key];
+  e.bitmap = Bitmap(image);
+  e.used   = true;
+  return e.bitmap;
+}
+
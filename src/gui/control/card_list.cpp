@@ -69,6 +69,8 @@ struct Freezer{
 void CardListBase::onAction(const Action& action, bool undone) {
   TYPE_CASE(action, AddCardAction) {
     Freezer freeze(this);
+    FOR_EACH_CONST(s, action.action.steps) sort_keys.erase(s.item.get());
+    resort_cards.clear(); // we resort everything
     if (action.action.adding != undone) {
       // select the new cards
       focusNone();
@@ -90,7 +92,14 @@ void CardListBase::onAction(const Action& action, bool undone) {
     }
   }
   TYPE_CASE(action, ReorderCardsAction) {
-    if (sort_by_column >= 0) return; // nothing changes for us
+    if (sort_by_column >= 0) {
+      if (max(action.card_id1, action.card_id2) >= set->cards.size()) return;
+      // the position in the list doesn't change, but the order of cards with equal sort keys does
+      auto it1 = item_order.find(set->cards[action.card_id1].get());
+      auto it2 = item_order.find(set->cards[action.card_id2].get());
+      if (it1 != item_order.end() && it2 != item_order.end()) swap(it1->second, it2->second);
+      return;
+    }
                 if ((long)action.card_id1 < 0 || (long)action.card_id2 >= (long)sorted_list.size()) return;
     if ((long)action.card_id1 == selected_item_pos || (long)action.card_id2 == selected_item_pos) {
       // Selected card has moved; also move in the sorted card list
@@ -103,12 +112,25 @@ void CardListBase::onAction(const Action& action, bool undone) {
     RefreshItem((long)action.card_id1);
     RefreshItem((long)action.card_id2);
   }
-  TYPE_CASE_(action, ScriptValueEvent) {
+  TYPE_CASE(action, ScriptValueEvent) {
     // No refresh needed, a ScriptValueEvent is only generated in response to a ValueAction
+    // But the sort keys can change
+    if (action.card) forgetSortKey(*action.card, *action.value);
     return;
   }
   TYPE_CASE(action, ValueAction) {
-    if (action.card) refreshList(true);
+    if (action.card) {
+      forgetSortKey(*action.card, *action.valueP);
+      if (isFiltered()) {
+        // the card might no longer match the filter
+        resort_cards.clear();
+        refreshList(true);
+      } else {
+        // move only the changed cards
+        resort_cards.push_back(action.card.get());
+        resortCards();
+      }
+    }
   }
 }
 
@@ -185,26 +207,63 @@ bool CardListBase::doDelete() {
 
 // Comparison object for comparing cards
 bool CardListBase::compareItems(void* a, void* b) const {
-  FieldP sort_field = column_fields[sort_by_column];
-  ValueP va = reinterpret_cast<Card*>(a)->data[sort_field];
-  ValueP vb = reinterpret_cast<Card*>(b)->data[sort_field];
-  assert(va && vb);
+  const SortKey& ka = sortKey(*reinterpret_cast<Card*>(a));
+  const SortKey& kb = sortKey(*reinterpret_cast<Card*>(b));
   // compare sort keys
-  int cmp = smart_compare( va->getSortKey(), vb->getSortKey() );
+  int cmp = smart_compare( ka.key, kb.key );
   if (cmp != 0) return cmp < 0;
   // equal values, compare alternate sort key
   if (alternate_sort_field) {
-    ValueP va = reinterpret_cast<Card*>(a)->data[alternate_sort_field];
-    ValueP vb = reinterpret_cast<Card*>(b)->data[alternate_sort_field];
-    int cmp = smart_compare( va->getSortKey(), vb->getSortKey() );
+    int cmp = smart_compare( ka.alternate_key, kb.alternate_key );
     if (cmp != 0) return cmp < 0;
   }
   return false;
 }
 
+const CardListBase::SortKey& CardListBase::sortKey(const Card& card) const {
+  FieldP sort_field = column_fields[sort_by_column];
+  if (sort_field != sort_keys_field) {
+    // sorting by a different column
+    sort_keys.clear();
+    sort_keys_field = sort_field;
+  }
+  auto it = sort_keys.find(&card);
+  if (it != sort_keys.end()) return it->second;
+  SortKey& key = sort_keys[&card];
+  ValueP v = card.data.at(sort_field->index);
+  assert(v);
+  key.key = v->getSortKey();
+  if (alternate_sort_field) {
+    key.alternate_key = card.data.at(alternate_sort_field->index)->getSortKey();
+  }
+  return key;
+}
+
+void CardListBase::forgetSortKey(const Card& card, const Value& value) {
+  if (sort_by_column < 0) return;
+  if (value.fieldP != column_fields[sort_by_column] && value.fieldP != alternate_sort_field) return;
+  sort_keys.erase(&card);
+  resort_cards.push_back(&card);
+}
+
+void CardListBase::resortCards() {
+  sort(resort_cards.begin(), resort_cards.end());
+  vector<VoidP> items;
+  FOR_EACH(item, sorted_list) {
+    if (binary_search(resort_cards.begin(), resort_cards.end(), reinterpret_cast<Card*>(item.get()))) {
+      items.push_back(item);
+    }
+  }
+  resort_cards.clear();
+  resortItems(items);
+}
+
 void CardListBase::rebuild() {
   ClearAll();
   column_fields.clear();
+  sort_keys.clear();
+  sort_keys_field = FieldP();
+  resort_cards.clear();
   selected_item_pos = -1;
   onRebuild();
   if (!set) return;
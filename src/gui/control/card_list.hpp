@@ -100,6 +100,8 @@ protected:
   virtual void onRebuild() {}
   /// Can the card list be modified?
   virtual bool allowModify() const { return false; }
+  /// Can changing the values of a card change whether it is in the list?
+  virtual bool isFiltered() const { return false; }
   /// Sort all card lists
   void sortBy(long column, bool ascending) override;
   
@@ -128,6 +130,23 @@ private:
   
   mutable wxListItemAttr item_attr; // for OnGetItemAttr
   
+  // sorting
+  struct SortKey {
+    String key;            ///< Sort key of the value in the sort field
+    String alternate_key;  ///< Sort key of the value in the alternate_sort_field
+  };
+  mutable FieldP sort_keys_field;  ///< Field for which the sort_keys were determined
+  mutable unordered_map<const Card*, SortKey> sort_keys; ///< Cached sort keys, script values are expensive to convert
+  vector<const Card*> resort_cards; ///< Cards of which the sort key has changed since the last refresh
+  
+  /// Get the (cached) sort key for a card
+  const SortKey& sortKey(const Card& card) const;
+  /// Forget the sort key of a card, if the value is used for sorting
+  /** If so, the card will be moved by resortCards */
+  void forgetSortKey(const Card& card, const Value& value);
+  /// Move the cards in resort_cards to their new position
+  void resortCards();
+  
 public:
   /// Open a dialog for selecting columns to be shown
   void selectColumns();
@@ -21,7 +21,6 @@ DEFINE_EVENT_TYPE(EVENT_SIZE_CHANGE);
 
 CardViewer::CardViewer(Window* parent, int id, long style)
   : wxControl(parent, id, wxDefaultPosition, wxDefaultSize, style)
-  , up_to_date(false)
 {
   SetBackgroundStyle(wxBG_STYLE_PAINT);
 }
@@ -38,13 +37,25 @@ wxSize CardViewer::DoGetBestSize() const {
   return cs;
 }
 
+wxRect CardViewer::viewerRect(const ValueViewer& v) const {
+  // grow a bit, to include anti aliased edges
+  return getRotation().trRectToBB(v.boundingBoxBorder()).grow(1).toRect();
+}
+
 void CardViewer::redraw(const ValueViewer& v) {
-  // Don't refresh if we OR ANOTHER CardViewer is drawing
+  if (!drawing.IsEmpty()) {
+    // A viewer changed because of a style update while we were drawing.
+    // If it is outside the area we are drawing it has to be drawn in a second pass.
+    dirty_drawing.Union(viewerRect(v));
+    return;
+  }
+  // Don't refresh if ANOTHER CardViewer is drawing
   // drawing another viewer causes styles to be updated for its active card, which may be different,
   // causing the two viewers to continously refresh.
   if (drawing_card()) return;
-  up_to_date = false;
-  RefreshRect(getRotation().trRectToBB(v.boundingBoxBorder()), false);
+  wxRect rect = viewerRect(v);
+  dirty.Union(rect);
+  RefreshRect(rect, false);
 }
 
 void CardViewer::onChange() {
@@ -53,7 +64,8 @@ void CardViewer::onChange() {
 
 void CardViewer::redraw() {
   if (drawing_card()) return;
-  up_to_date = false;
+  wxSize cs = GetClientSize();
+  dirty = wxRegion(0, 0, cs.GetWidth(), cs.GetHeight());
   Refresh(false);
 }
 
@@ -86,33 +98,52 @@ void CardViewer::onPaint(wxPaintEvent&) {
   }
   if (!buffer.Ok() || buffer.GetWidth() != cs.GetWidth() || buffer.GetHeight() != cs.GetHeight()) {
     buffer = Bitmap(cs.GetWidth(), cs.GetHeight());
-    up_to_date = false;
+    dirty = wxRegion(0, 0, cs.GetWidth(), cs.GetHeight());
   }
   wxBufferedPaintDC dc(this, buffer);
-  // scrolling
-//  int dx = GetScrollPos(wxHORIZONTAL), dy = GetScrollPos(wxVERTICAL);
-//  dc.SetDeviceOrigin(-dx, -dy);
-  wxRegion clip = GetUpdateRegion();
-//  clip.Offset(dx, dy);
-  dc.SetDeviceClippingRegion(clip);
-  // draw
-  if (!up_to_date) {
-    up_to_date = true;
+  // draw only the out of date parts of the buffer,
+  // the rest of the update region is copied from the buffer when dc is destroyed
+  if (!dirty.IsEmpty()) {
+    drawing = dirty;
+    dirty.Clear();
+    dc.SetDeviceClippingRegion(drawing);
     try {
       draw(dc);
     } CATCH_ALL_ERRORS(false); // don't show message boxes in onPaint!
+    dc.DestroyClippingRegion();
+    // viewers that were changed by the style update, but that we didn't draw
+    dirty_drawing.Subtract(drawing);
+    drawing.Clear();
+    if (!dirty_drawing.IsEmpty()) {
+      dirty = dirty_drawing;
+      dirty_drawing.Clear();
+      RefreshRect(dirty.GetBox(), false);
+    }
   }
 }
 
 void CardViewer::drawViewer(RotatedDC& dc, ValueViewer& v) {
-  if (shouldDraw(v)) v.draw(dc);
+  if (!shouldDraw(v)) return;
+  drawLayered(dc, v);
+  if (settings.show_render_cache) drawRenderCache(dc, v);
+}
+
+void CardViewer::drawRenderCache(RotatedDC& dc, const ValueViewer& v) {
+  // show which viewers had to render their text again
+  wxDC& raw = dc.getDC();
+  wxRect r = dc.getExternalRect().toRect();
+  Color c = v.text_layer.misses ? Color(255,0,0) : Color(0,160,0);
+  raw.SetPen(c);
+  raw.SetBrush(*wxTRANSPARENT_BRUSH);
+  raw.DrawRectangle(r);
+  raw.SetFont(*wxSMALL_FONT);
+  raw.SetTextForeground(c);
+  raw.DrawText(String::Format(_("%d/%d"), (int)v.text_layer.hits, (int)v.text_layer.misses), r.x + 1, r.y + 1);
 }
 
 bool CardViewer::shouldDraw(const ValueViewer& v) const {
-//  int dx = GetScrollPos(wxHORIZONTAL), dy = GetScrollPos(wxVERTICAL);
-//  wxRegion clip = GetUpdateRegion();
-//  clip.Offset(dx, dy);
-  return GetUpdateRegion().Contains(getRotation().trRectToBB(v.boundingBoxBorder().toRect()).toRect()) != wxOutRegion;
+  // only the viewers that overlap the out of date region have to be composited again
+  return drawing.Contains(viewerRect(v)) != wxOutRegion;
 }
 
 // helper class for overdrawDC()
@@ -50,14 +50,21 @@ protected:
   bool shouldDraw(const ValueViewer&) const;
   
   void drawViewer(RotatedDC& dc, ValueViewer& v) override;
+  /// Mark a viewer with the number of text layer hits and misses, for settings.show_render_cache
+  void drawRenderCache(RotatedDC& dc, const ValueViewer& v);
   
 private:
   DECLARE_EVENT_TABLE();
   
   void onPaint(wxPaintEvent&);
   
-  Bitmap buffer;     ///< Off-screen buffer we draw to
-  bool   up_to_date; ///< Is the buffer up to date?
+  Bitmap   buffer;        ///< Off-screen buffer we draw to
+  wxRegion dirty;         ///< Part of the buffer that is out of date
+  wxRegion drawing;       ///< Part of the buffer we are currently drawing, empty if not drawing
+  wxRegion dirty_drawing; ///< Viewers that changed while we were drawing, they are redrawn afterwards
+  
+  /// Area of the control covered by a viewer
+  wxRect viewerRect(const ValueViewer&) const;
   
   class OverdrawDC;
   class OverdrawDC_aux;
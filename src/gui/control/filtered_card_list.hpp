@@ -27,6 +27,7 @@ public:
 protected:
   /// Get only the subset of the cards
   void getItems(vector<VoidP>& out) const override;
+  bool isFiltered() const override { return true; }
   
   void onChangeSet() override;
   
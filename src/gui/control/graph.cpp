@@ -19,244 +19,6 @@ template <typename T> inline T sgn(T v) { return v < 0 ? -1 : 1; }
 
 DEFINE_EVENT_TYPE(EVENT_GRAPH_SELECT);
 
-// ----------------------------------------------------------------------------- : GraphAxis
-
-void GraphAxis::addGroup(const String& name, UInt size) {
-  if (!groups.empty() && groups.back().name == name) {
-    groups.back().size += size;
-  } else {
-    groups.push_back(GraphGroup(name, size));
-  }
-  max = std::max(max, groups.back().size);
-  total += size;
-}
-
-// ----------------------------------------------------------------------------- : GraphData
-
-struct ComparingOriginalIndex {
-  inline bool operator () (const GraphElementP& a, const GraphElementP& b) {
-    return a->original_index < b->original_index;
-  }
-};
-
-void GraphDataPre::splitList(size_t axis) {
-  size_t count = elements.size(); // only the elements that were already there
-  for (size_t i = 0 ; i < count ; ++i) {
-    GraphElement& e = *elements[i];
-    String& v = e.values[axis];
-    size_t comma = v.find_first_of(_(','));
-    while (comma != String::npos) {
-      // split
-      GraphElementP e2(new GraphElement(e));
-      e2->values[axis] = v.substr(0,comma);
-      elements.push_back(e2);
-      if (is_substr(v, comma, _(", "))) ++comma; // skip space after it
-      v = v.substr(comma + 1);
-      comma = v.find_first_of(_(','));
-    }
-  }
-  // re-sort by original_index
-  sort(elements.begin(), elements.end(), ComparingOriginalIndex());
-}
-
-
-struct SmartLess{
-  inline bool operator () (const String& a, const String& b) const { return smart_less(a,b); }
-};
-
-String to_bin(double value, double bin_size) {
-  if (bin_size <= 0 || value == 0) {
-    return String() << (int)value;
-  } else {
-    int bin = ceil(value / bin_size);
-    return String::Format(_("%.0f%c%.0f"), (bin-1) * bin_size + 1, EN_DASH, bin * bin_size);
-  }
-}
-int bin_to_group(double value, double bin_size) {
-  if (bin_size <= 0 || value == 0) {
-    return 0;
-  } else {
-    return ceil(value / bin_size);
-  }
-}
-
-GraphData::GraphData(const GraphDataPre& d)
-  : axes(d.axes)
-{
-  // find groups on each axis
-  size_t i = 0;
-  for (auto const& a : axes) {
-    map<String,UInt,SmartLess> counts; // note: default constructor for UInt() does initialize to 0
-    FOR_EACH_CONST(e, d.elements) {
-      assert(e->values.size() == axes.size());
-      counts[e->values[i]] += 1;
-    }
-    if (a->numeric) {
-      // Add all values, calculate mean of the numeric ones
-      UInt numeric_count = 0;
-      int prev = 0;
-      FOR_EACH(c, counts) {
-        // numeric?
-        double d;
-        if (c.first.ToDouble(&d)) {
-          // update mean
-          a->mean_value += d * c.second;
-          a->max_value  = max(a->max_value, d);
-          numeric_count += c.second;
-          // add 0 bars before this value
-          int next = (int)floor(d);
-          for (int i = prev ; i < next ; i++) {
-            a->addGroup(to_bin(i, a->bin_size), 0);
-          }
-          prev = next + 1;
-          // add
-          if (a->bin_size) {
-            a->addGroup(to_bin(d, a->bin_size), c.second);
-          } else {
-            a->addGroup(c.first, c.second);
-          }
-        } else {
-          // non-numeric, add anyway
-          a->addGroup(c.first, c.second);
-        }
-      }
-      a->mean_value /= numeric_count;
-    } else if (a->order) {
-      // specific group order
-      FOR_EACH_CONST(gn, *a->order) {
-        a->addGroup(gn, counts[gn]);
-      }
-    } else {
-      FOR_EACH(c, counts) {
-        a->addGroup(c.first, c.second);
-      }
-    }
-    // colors
-    if (a->auto_color == AUTO_COLOR_NO && a->colors) {
-      // use colors from the table
-      FOR_EACH(g, a->groups) {
-        map<String,Color>::const_iterator it = a->colors->find(g.name);
-        if (it != a->colors->end()) {
-          g.color = it->second;
-        }
-      }
-    } else {
-      // find some nice colors for the groups
-      double step = 0;
-      bool first = true;
-      FOR_EACH(g, a->groups) {
-        double amount = a->auto_color == AUTO_COLOR_EVEN
-                          ? 1. / a->groups.size()
-                          : double(g.size) / a->total; // amount this group takes
-        if (!first) step += amount/2;
-        if (a->numeric) {
-          g.color = hsl2rgb(0.65 - 0.82 * step, 0.9 - 0.2 * fabs(step - 0.5), 0.3 + 0.35 * step);
-        } else {
-          g.color = hsl2rgb(0.6 + step, 0.9, 0.5);
-        }
-        step += amount / 2;
-        first = false;
-      }
-    }
-    ++i;
-  }
-  // count elements in each position
-  values.reserve(d.elements.size());
-  size_t de_size = sizeof(GraphDataElement) + sizeof(int) * (axes.size() - 1);
-  FOR_EACH_CONST(e, d.elements) {
-    // make the group_nrs large enough
-    GraphDataElement* de = reinterpret_cast<GraphDataElement*>(new char[de_size]);
-    de->original_index = e->original_index;
-    // find index j in elements
-    int i = 0;
-    FOR_EACH(a, axes) {
-      String v = e->values[i];
-      de->group_nrs[i] = -1;
-      double d;
-      if (a->numeric && a->bin_size > 0 && v.ToDouble(&d)) {
-        // calculate group that contains v
-        de->group_nrs[i] = bin_to_group(d, a->bin_size);
-      } else {
-        // find group that contains v
-        int j = 0;
-        FOR_EACH(g, a->groups) {
-          if (v == g.name) {
-            de->group_nrs[i] = j;
-            break;
-          }
-          ++j;
-        }
-      }
-      ++i;
-    }
-    values.push_back(de);
-  }
-}
-
-GraphData::~GraphData() {
-  FOR_EACH_CONST(v,values) delete v;
-}
-
-void GraphData::crossAxis(size_t axis1, size_t axis2, vector<UInt>& out) const {
-  size_t a1_size = axes[axis1]->groups.size();
-  size_t a2_size = axes[axis2]->groups.size();
-  out.clear();
-  out.resize(a1_size * a2_size, 0);
-  FOR_EACH_CONST(v, values) {
-    int v1 = v->group_nrs[axis1], v2 = v->group_nrs[axis2];
-    if (v1 >= 0 && v2 >= 0) {
-      out[a2_size * v1 + v2]++;
-    }
-  }
-}
-
-void GraphData::crossAxis(size_t axis1, size_t axis2, size_t axis3, vector<UInt>& out) const {
-  size_t a1_size = axes[axis1]->groups.size();
-  size_t a2_size = axes[axis2]->groups.size();
-  size_t a3_size = axes[axis3]->groups.size();
-  out.clear();
-  out.resize(a1_size * a2_size * a3_size, 0);
-  FOR_EACH_CONST(v, values) {
-    int v1 = v->group_nrs[axis1], v2 = v->group_nrs[axis2], v3 = v->group_nrs[axis3];
-    if (v1 >= 0 && v2 >= 0 && v3 >= 0) {
-      out[a3_size * (a2_size * v1 + v2) + v3]++;
-    }
-  }
-}
-
-bool matches(const GraphDataElement* v, const vector<int>& match) {
-  for (size_t i = 0 ; i < match.size() ; ++i) {
-    if (v->group_nrs[i] == -1 || (match[i] != -1 && v->group_nrs[i] != match[i])) {
-      return false;
-    }
-  }
-  return true;
-}
-
-UInt GraphData::count(const vector<int>& match) const {
-  if (match.size() != axes.size()) return 0;
-  UInt count = 0;
-  size_t prev_index = (size_t)-1;
-  FOR_EACH_CONST(v, values) {
-    if (matches(v, match) && v->original_index != prev_index) {
-      prev_index = v->original_index; // don't count the same index twice
-      count += matches(v, match);
-    }
-  }
-  return count;
-}
-
-void GraphData::indices(const vector<int>& match, vector<size_t>& out) const {
-  if (match.size() != axes.size()) return;
-  size_t prev_index = (size_t)-1;
-  FOR_EACH_CONST(v, values) {
-    if (matches(v, match) && v->original_index != prev_index) {
-      prev_index = v->original_index; // don't select the same index twice
-      out.push_back(v->original_index);
-    }
-  }
-}
-
 // ----------------------------------------------------------------------------- : Graph1D
 
 void Graph1D::draw(RotatedDC& dc, const vector<int>& current, DrawLayer layer) const {
@@ -12,10 +12,8 @@
 #include <util/alignment.hpp>
 #include <util/rotation.hpp>
 #include <data/graph_type.hpp>
+#include <data/graph_data.hpp>
 
-DECLARE_POINTER_TYPE(GraphAxis);
-DECLARE_POINTER_TYPE(GraphElement);
-DECLARE_POINTER_TYPE(GraphData);
 DECLARE_POINTER_TYPE(Graph);
 
 // ----------------------------------------------------------------------------- : Events
@@ -25,108 +23,6 @@ DECLARE_LOCAL_EVENT_TYPE(EVENT_GRAPH_SELECT, <not used>)
 /// Handle EVENT_GRAPH_SELECT events
 #define EVT_GRAPH_SELECT(id, handler) EVT_COMMAND(id, EVENT_GRAPH_SELECT, handler)
 
-// ----------------------------------------------------------------------------- : Graph data
-
-/// A group in a table or graph
-/** This corresponds to a specific value on an axis. For example "red" would be a GraphGroup for the "color" GraphAxis
- *  A group is rendered as a single bar or pie slice.
- */
-class GraphGroup : public IntrusivePtrBase<GraphGroup> {
-public:
-  GraphGroup(const String& name, UInt size, const Color& color = *wxBLACK)
-    : name(name), color(color), size(size)
-  {}
-  
-  String name;  ///< Name of this position
-  Color  color;  ///< Associated color
-  UInt   size;  ///< Number of elements in this group
-};
-
-/// Automatic coloring mode
-enum AutoColor
-{  AUTO_COLOR_NO
-,  AUTO_COLOR_EVEN
-,  AUTO_COLOR_WEIGHTED
-};
-
-/// An axis in a graph, consists of a list of groups
-/** The sum of groups.sum = sum of all elements in the data */
-class GraphAxis : public IntrusivePtrBase<GraphAxis> {
-public:
-  GraphAxis(const String& name, AutoColor auto_color = AUTO_COLOR_EVEN, bool numeric = false, double bin_size = 0, const map<String,Color>* colors = nullptr, const vector<String>* order = nullptr)
-    : name(name)
-    , auto_color(auto_color)
-    , numeric(numeric), bin_size(bin_size)
-    , max(0)
-    , total(0)
-    , mean_value(0), max_value(-numeric_limits<double>::infinity())
-    , colors(colors)
-    , order(order)
-  {}
-  
-  String                   name;         ///< Name/label of this axis
-  AutoColor                auto_color;   ///< Automatically assign colors to the groups on this axis
-  vector<GraphGroup>       groups;       ///< Groups along this axis
-  bool                     numeric;      ///< Numeric axis?
-  double                   bin_size;     ///< Group numeric values into bins of this size
-  UInt                     max;          ///< Maximum size of the groups
-  UInt                     total;        ///< Sum of the size of all groups
-  double                   mean_value;   ///< Mean value, only for numeric axes
-  double                   max_value;    ///< Maximal value, only for numeric axes
-  const map<String,Color>* colors;       ///< Colors for each choice (optional)
-  const vector<String>*    order;        ///< Order of the items (optional)
-  
-  /// Add a graph group
-  void addGroup(const String& name, UInt size);
-};
-
-/// A single data point of a graph
-class GraphElement : public IntrusivePtrBase<GraphElement> {
-public:
-  GraphElement(size_t original_index) : original_index(original_index) {}
-  
-  size_t         original_index; ///< Corresponding index in the original input
-  vector<String> values;         ///< Group name for each axis
-};
-
-/// Data to be displayed in a graph, not processed yet
-/** Requires: for (e : elements) e.values.size() == axes.size()
- */
-class GraphDataPre {
-public:
-  vector<GraphAxisP>    axes;
-  vector<GraphElementP> elements;
-  /// Split compound elements, "a,b,c" -> "a" and "b" and "c"
-  void splitList(size_t axis);
-};
-
-/// A single data point of a graph
-struct GraphDataElement {
-  size_t original_index;
-  int    group_nrs[1];   ///< Group number for each axis
-};
-
-/// Data to be displayed in a graph
-class GraphData : public IntrusivePtrBase<GraphData> {
-public:
-  GraphData(const GraphDataPre&);
-  ~GraphData();
-  
-  vector<GraphAxisP>        axes;    ///< The axes in the data
-  vector<GraphDataElement*> values;  ///< All elements, with the group number for each axis, or -1
-  UInt                      size;    ///< Total number of elements
-  
-  /// Create a cross table for two axes
-  void crossAxis(size_t axis1, size_t axis2, vector<UInt>& out) const;
-  /// Create a cross table for three axes
-  void crossAxis(size_t axis1, size_t axis2, size_t axis3, vector<UInt>& out) const;
-  /// Count the number of elements with the given values, -1 is a wildcard
-  UInt count(const vector<int>& match) const;
-  /// Get the original_indices of elements matching the selection
-  void indices(const vector<int>& match, vector<size_t>& out) const;
-};
-
-
 // ----------------------------------------------------------------------------- : Graph
 
 enum DrawLayer
@@ -51,6 +51,7 @@ public:
 protected:
   /// Get only the subset of the cards
   void getItems(vector<VoidP>& out) const override;
+  bool isFiltered() const override { return !!filter; }
   void onChangeSet() override;
   
   private:  
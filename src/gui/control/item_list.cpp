@@ -153,13 +153,14 @@ long ItemList::focusCount() const {
 struct ItemList::ItemComparer {
   ItemComparer(ItemList& list) : list(list) {}
   ItemList&   list; // 'this' pointer
-  // Compare two items using the current criterium and order
+  // Compare two items using the current criterium and order,
+  // break ties with the original order, so inserting an item in a sorted list gives the same result as sorting
   bool operator () (const VoidP& a, const VoidP& b) {
-    if (list.sort_ascending) {
-      return list.compareItems(a.get(), b.get());
-    } else {
-      return list.compareItems(b.get(), a.get());
-    }
+    void* first  = list.sort_ascending ? a.get() : b.get();
+    void* second = list.sort_ascending ? b.get() : a.get();
+    if (list.compareItems(first, second)) return true;
+    if (list.compareItems(second, first)) return false;
+    return list.item_order[a.get()] < list.item_order[b.get()];
   }
 };
 
@@ -168,9 +169,13 @@ void ItemList::refreshList(bool refresh_current_only) {
   vector<VoidP> old_sorted_list;
   swap(sorted_list, old_sorted_list);
   getItems(sorted_list);
+  item_order.clear();
+  for (size_t i = 0 ; i < sorted_list.size() ; ++i) {
+    item_order[sorted_list[i].get()] = i;
+  }
   // Sort the list
   if (sort_by_column >= 0) {
-    stable_sort(sorted_list.begin(), sorted_list.end(), ItemComparer(*this));
+    sort(sorted_list.begin(), sorted_list.end(), ItemComparer(*this));
   }
   // Has the entire list changed?
   if (refresh_current_only && sorted_list == old_sorted_list) {
@@ -194,6 +199,63 @@ void ItemList::refreshList(bool refresh_current_only) {
   }
 }
 
+void ItemList::resortItems(const vector<VoidP>& items) {
+  if (items.empty()) return;
+  if (items.size() > sorted_list.size() / 8 + 1) {
+    // it's cheaper to just sort everything
+    refreshList();
+    return;
+  }
+  // sorted lookup of the changed items, so finding them is a single pass over the list
+  vector<void*> changed_items;
+  FOR_EACH_CONST(item, items) changed_items.push_back(item.get());
+  sort(changed_items.begin(), changed_items.end());
+  auto changed = [&](const VoidP& item) {
+    return binary_search(changed_items.begin(), changed_items.end(), item.get());
+  };
+  if (sort_by_column < 0) {
+    // the order doesn't change
+    for (long pos = 0 ; pos < (long)sorted_list.size() ; ++pos) {
+      if (changed(sorted_list[pos])) RefreshItem(pos);
+    }
+    return;
+  }
+  // take the changed items out, the rest of the list stays sorted
+  vector<VoidP> old_sorted_list = sorted_list;
+  vector<VoidP> taken;
+  size_t kept = 0;
+  for (size_t pos = 0 ; pos < sorted_list.size() ; ++pos) {
+    if (changed(sorted_list[pos])) {
+      taken.push_back(sorted_list[pos]);
+    } else {
+      sorted_list[kept++] = sorted_list[pos];
+    }
+  }
+  sorted_list.resize(kept);
+  // and put them back at their new position
+  ItemComparer less(*this);
+  for (auto const& item : taken) {
+    sorted_list.insert(upper_bound(sorted_list.begin(), sorted_list.end(), item, less), item);
+  }
+  // range of positions to refresh: the changed items, and everything that moved
+  long first = (long)sorted_list.size(), last = -1;
+  for (size_t pos = 0 ; pos < sorted_list.size() ; ++pos) {
+    if (sorted_list[pos] != old_sorted_list[pos] || changed(sorted_list[pos])) {
+      first = min(first, (long)pos);
+      last  = max(last,  (long)pos);
+    }
+  }
+  if (sorted_list != old_sorted_list) {
+    // (re)select current item
+    findSelectedItemPos();
+    focusNone();
+    focusSelectedItem(true);
+  }
+  if (first <= last) {
+    RefreshItems(first, last);
+  }
+}
+
 void ItemList::sortBy(long column, bool ascending) {
   // Change image in column header
   long count = GetColumnCount();
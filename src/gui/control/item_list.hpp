@@ -66,6 +66,7 @@ protected:
   /// Is sorting required?
   virtual bool mustSort() const { return false; }
   /// Compare two items for < based on sort_by_column (not on sort_ascending)
+  /** Items that compare equal are kept in the order of getItems, in both directions */
   virtual bool compareItems(void* a, void* b) const = 0;
   
   // --------------------------------------------------- : Protected interface
@@ -75,6 +76,11 @@ protected:
   virtual void sortBy(long column, bool ascending);
   /// Refresh the card list (resort, refresh and reselect current item)
   void refreshList(bool refresh_current_only = false);
+  /// Refresh some items of which the sort key may have changed, and move them to their new position.
+  /** This avoids resorting the whole list when only a few items change.
+   *  The set of items in the list must not have changed.
+   */
+  void resortItems(const vector<VoidP>& items);
   /// Set the image of a column header (fixes wx bug)
   void SetColumnImage(int col, int image);
   
@@ -107,6 +113,8 @@ protected:
   long           sort_by_column;    ///< Column to use for sorting, or -1 if not sorted
   bool           sort_ascending;    ///< Sort order
   vector<VoidP>  sorted_list;       ///< Sorted list of items, can be considered a map: pos->item
+  /// Position of each item in the list returned by getItems, items that compare equal stay in that order
+  unordered_map<void*,size_t> item_order;
   
 private:
   struct ItemComparer; // for comparing items
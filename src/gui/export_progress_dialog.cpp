@@ -0,0 +1,22 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <gui/export_progress_dialog.hpp>
+
+// ----------------------------------------------------------------------------- : ExportProgressDialog
+
+ExportProgressDialog::ExportProgressDialog(Window* parent, const String& title, const String& message)
+  : wxProgressDialog(title, message, 1000, parent, wxPD_APP_MODAL | wxPD_SMOOTH | wxPD_CAN_ABORT)
+{}
+
+void ExportProgressDialog::onProgress(float progress, const String& message) {
+  if (!Update(int(progress * 1000), message)) {
+    throw AbortException();
+  }
+}
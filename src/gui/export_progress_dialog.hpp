@@ -0,0 +1,26 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <data/format/formats.hpp> // WithProgress
+#include <wx/progdlg.h>
+
+// ----------------------------------------------------------------------------- : ExportProgressDialog
+
+/// A dialog to show the progress of exporting
+class ExportProgressDialog : public wxProgressDialog, public WithProgress {
+public:
+  ExportProgressDialog(Window* parent, const String& title, const String& message);
+  
+  /// Update the progress bar
+  /** if the operation should be aborted, throws an AbortException
+   */
+  void onProgress(float progress, const String& message) override;
+};
@@ -15,6 +15,7 @@
 #include <data/card.hpp>
 #include <data/settings.hpp>
 #include <data/export_template.hpp>
+#include <data/format/image_writer.hpp>
 #include <util/window_id.hpp>
 #include <util/error.hpp>
 #include <util/platform.hpp>
@@ -69,6 +70,8 @@ ScriptValueP export_set(SetP const& set, vector<CardP> const& cards, ExportTempl
     if (!wxDirExists(info.directory_absolute)) {
       wxMkdir(info.directory_absolute);
     }
+    // images are encoded and written by background threads, while the script goes on with the next card
+    info.image_writer = make_unique<ImageWriterPool>(max(1, wxThread::GetCPUCount() - 1));
   }
   // run export script
   Context& ctx = set->getContext();
@@ -83,8 +86,10 @@ ScriptValueP export_set(SetP const& set, vector<CardP> const& cards, ExportTempl
     // write as string
     wxFileOutputStream file(outname);
     wxTextOutputStream stream(file);
-    stream.WriteString(result->toString());
+    writeUTF8(stream, result->toString());
   }
+  // the main file is written even if some images could not be
+  info.finish();
   return result;
 }
 
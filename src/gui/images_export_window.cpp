@@ -9,6 +9,7 @@
 #include <util/prec.hpp>
 #include <gui/images_export_window.hpp>
 #include <gui/control/select_card_list.hpp>
+#include <gui/export_progress_dialog.hpp>
 #include <data/settings.hpp>
 #include <data/set.hpp>
 #include <data/format/formats.hpp>
@@ -65,7 +66,12 @@ void ImagesExportWindow::onOk(wxCommandEvent&) {
   if (name.empty()) return;
   settings.default_export_dir = wxPathOnly(name);
   // Export
-  export_images(set, getSelection(), name, gs.images_export_filename, gs.images_export_conflicts);
+  try {
+    ExportProgressDialog progress(this, _TITLE_("export images"), name);
+    export_images(set, getSelection(), name, gs.images_export_filename, gs.images_export_conflicts, &progress);
+  } catch (const AbortException&) {
+    // aborted by the user, the images written so far are kept
+  }
   // Done
   EndModal(wxID_OK);
 }
@@ -12,6 +12,7 @@
 #include <data/settings.hpp>
 #include <util/window_id.hpp>
 #include <util/io/package_manager.hpp>
+#include <gfx/image_cache.hpp>
 #include <wx/spinctrl.h>
 #include <wx/filename.h>
 #include <wx/notebook.h>
@@ -80,6 +81,9 @@ private:
   wxComboBox* internal_scale;
   int internal_scale_int;
 
+  wxSpinCtrl* image_cache_size;
+  wxCheckBox* show_render_cache;
+
   void onInternalScaleChange(wxCommandEvent&);
   void updateInternalScale();
 };
@@ -322,8 +326,11 @@ END_EVENT_TABLE  ()
 InternalPreferencesPage::InternalPreferencesPage(Window* parent) : PreferencesPage(parent) {
   internal_image_extension = new wxCheckBox(this, wxID_ANY, _BUTTON_("internal image extension"));
   internal_scale = new wxComboBox(this, ID_INTERNAL_SCALE);
+  image_cache_size = new wxSpinCtrl(this, wxID_ANY, _(""), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 4096, settings.image_cache_size);
+  show_render_cache = new wxCheckBox(this, wxID_ANY, _BUTTON_("show render cache"));
 
   internal_image_extension->SetValue(settings.internal_image_extension);
+  show_render_cache->SetValue(settings.show_render_cache);
 
   internal_scale_int = static_cast<int>(settings.internal_scale * 100);
   internal_scale->SetValue(String::Format(_("%d%%"), internal_scale_int));
@@ -343,6 +350,13 @@ InternalPreferencesPage::InternalPreferencesPage(Window* parent) : PreferencesPa
     s2->Add(s3);
     s2->Add(new wxStaticText(this, wxID_ANY, _LABEL_("internal scale desc")), 0, wxALL & ~wxLEFT, 4);
     s2->Add(internal_image_extension, 0, wxEXPAND | wxALL, 4);
+    wxSizer* s4 = new wxBoxSizer(wxHORIZONTAL);
+      s4->Add(new wxStaticText(this, wxID_ANY, _LABEL_("image cache size")), 0, wxALL & ~wxLEFT, 4);
+      s4->AddSpacer(2);
+      s4->Add(image_cache_size);
+      s4->Add(new wxStaticText(this, wxID_ANY, _LABEL_("megabytes")), 1, wxALL & ~wxRIGHT, 4);
+    s2->Add(s4);
+    s2->Add(show_render_cache, 0, wxEXPAND | wxALL, 4);
   s->Add(s2, 0, wxEXPAND | wxALL, 8);
   s->SetSizeHints(this);
   SetSizer(s);
@@ -353,6 +367,10 @@ void InternalPreferencesPage::store() {
 
   updateInternalScale();
   settings.internal_scale = internal_scale_int / 100.0;
+
+  settings.image_cache_size = image_cache_size->GetValue();
+  image_cache.setBudget(settings.image_cache_size * 1024 * 1024);
+  settings.show_render_cache = show_render_cache->GetValue();
 }
 
 void InternalPreferencesPage::onInternalScaleChange(wxCommandEvent&) {
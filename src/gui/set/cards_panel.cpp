@@ -19,6 +19,7 @@
 #include <data/game.hpp>
 #include <data/card.hpp>
 #include <data/add_cards_script.hpp>
+#include <data/card_search.hpp>
 #include <data/action/set.hpp>
 #include <data/settings.hpp>
 #include <util/find_replace.hpp>
@@ -349,7 +350,12 @@ void CardsPanel::onCommand(int id) {
     }
     case ID_CARD_FILTER: {
       // card filter has changed, update the card list
-      card_list->setFilter(filter->getFilter<Card>());
+      if (filter->hasFilter()) {
+        // use the search index of the set
+        card_list->setFilter(make_intrusive<CardQuickFilter>(set, filter->getFilterString()));
+      } else {
+        card_list->setFilter(CardListFilterP());
+      }
       break;
     }
     default: {
@@ -13,11 +13,11 @@
 #include <gui/control/filtered_card_list.hpp>
 #include <gui/util.hpp>
 #include <data/game.hpp>
+#include <data/set.hpp>
 #include <data/statistics.hpp>
 #include <data/action/value.hpp>
 #include <util/window_id.hpp>
 #include <util/alignment.hpp>
-#include <util/tagged_string.hpp>
 #include <gfx/gfx.hpp>
 #include <wx/splitter.h>
 
@@ -460,50 +460,8 @@ void StatsPanel::showCategory(const GraphType* prefer_layout) {
     // layout
     GraphType layout = cat.type;
   #endif
-  // create axes
   GraphDataPre d;
-  FOR_EACH(dim, dims) {
-    d.axes.push_back(make_intrusive<GraphAxis>(
-      dim->name,
-      dim->colors.empty() ? AUTO_COLOR_EVEN : AUTO_COLOR_NO,
-      dim->numeric,
-      dim->bin_size,
-      &dim->colors,
-      dim->groups.empty() ? nullptr : &dim->groups
-      )
-    );
-  }
-  // find values for each card
-  for (size_t i = 0 ; i < set->cards.size() ; ++i) {
-    Context& ctx = set->getContext(set->cards[i]);
-    GraphElementP e = make_intrusive<GraphElement>(i);
-    bool show = true;
-    FOR_EACH(dim, dims) {
-      try {
-        String value = untag(dim->script.invoke(ctx)->toString());
-        e->values.push_back(value);
-        if (value.empty() && !dim->show_empty) {
-          // don't show this element
-          show = false;
-          break;
-        }
-      } catch (ScriptError const& e) {
-        handle_error(ScriptError(e.what() + _("\n  in script for statistics dimension '") + dim->name + _("'")));
-        show = false;
-        break;
-      }
-    }
-    if (show) {
-      assert(e->values.size() == dims.size());
-      d.elements.push_back(e);
-    }
-  }
-  // split lists
-  size_t dim_id = 0;
-  FOR_EACH(dim, dims) {
-    if (dim->split_list) d.splitList(dim_id);
-    ++dim_id;
-  }
+  set->statsTable().graphData(dims, d);
   // update graph and card list
   graph->setLayout(layout, true);
   graph->setData(d);
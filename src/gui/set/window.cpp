@@ -850,6 +850,8 @@ void SetWindow::onMenuOpen(wxMenuEvent& ev) {
 void SetWindow::onIdle(wxIdleEvent& ev) {
   // Stuff that must be done in the main thread
   show_update_dialog(this);
+  // mark the words the spell checker has finished with
+  if (set) set->updateSpellChecked();
 }
 
 // ----------------------------------------------------------------------------- : Event table
@@ -811,7 +811,7 @@ bool TextValueEditor::canFormat(int type) const {
       return !style().always_symbol && style().allow_formating && style().symbol_font.valid();
     case ID_FORMAT_REMINDER:
       return !style().always_symbol && style().allow_formating &&
-             is_in_tag(value().value(), _("<kw"), selection_start_i, selection_start_i);
+             taggedValue().isInTag(_("<kw"), selection_start_i, selection_start_i);
     default:
       return false;
   }
@@ -820,13 +820,13 @@ bool TextValueEditor::canFormat(int type) const {
 bool TextValueEditor::hasFormat(int type) const {
   switch (type) {
     case ID_FORMAT_BOLD:
-      return is_in_tag(value().value(), _("<b"),   selection_start_i, selection_end_i);
+      return taggedValue().isInTag(_("<b"),   selection_start_i, selection_end_i);
     case ID_FORMAT_ITALIC:
-      return is_in_tag(value().value(), _("<i"),   selection_start_i, selection_end_i);
+      return taggedValue().isInTag(_("<i"),   selection_start_i, selection_end_i);
     case ID_FORMAT_UNDERLINE:
-      return is_in_tag(value().value(), _("<u"), selection_start_i, selection_end_i);
+      return taggedValue().isInTag(_("<u"), selection_start_i, selection_end_i);
     case ID_FORMAT_SYMBOL:
-      return is_in_tag(value().value(), _("<sym"), selection_start_i, selection_end_i);
+      return taggedValue().isInTag(_("<sym"), selection_start_i, selection_end_i);
     case ID_FORMAT_REMINDER: {
       const String& v = value().value();
       size_t tag = in_tag(v, _("<kw"),  selection_start_i, selection_start_i);
@@ -1089,29 +1089,37 @@ Movement direction_of(size_t a, size_t b) {
   else       return MOVE_MID;
 }
 
+const TaggedText& TextValueEditor::taggedValue() const {
+  if (tagged_value.str() != value().value()) {
+    tagged_value.assign(value().value());
+  }
+  return tagged_value;
+}
+
 void TextValueEditor::fixSelection(IndexType t, Movement dir) {
-  const String& val = value().value();
+  const TaggedText& tagged = taggedValue();
+  const String& val = tagged.str();
   // Which type takes precedent?
   if (t == TYPE_INDEX) {
-    selection_start = index_to_cursor(value().value(), selection_start_i, dir);
-    selection_end   = index_to_cursor(value().value(), selection_end_i,   dir);
+    selection_start = tagged.indexToCursor(selection_start_i, dir);
+    selection_end   = tagged.indexToCursor(selection_end_i,   dir);
   }
   // make sure the selection is at a valid position inside the text
   // prepare to move 'inward' (i.e. from start in the direction of end and vice versa)
-  selection_start_i = cursor_to_index(val, selection_start, direction_of(selection_end, selection_start));
-  selection_end_i   = cursor_to_index(val, selection_end,   direction_of(selection_start, selection_end));
+  selection_start_i = tagged.cursorToIndex(selection_start, direction_of(selection_end, selection_start));
+  selection_end_i   = tagged.cursorToIndex(selection_end,   direction_of(selection_start, selection_end));
   // start and end must be on the same side of separators
   size_t seppos = val.find(_("<sep"));
   while (seppos != String::npos) {
     size_t sepend = match_close_tag_end(val, seppos);
     if (selection_start_i <= seppos && selection_end_i > seppos) {
         // not on same side, move selection end before sep
-      selection_end   = index_to_cursor(val, seppos, dir);
-      selection_end_i = cursor_to_index(val, selection_end, direction_of(selection_start, selection_end));
+      selection_end   = tagged.indexToCursor(seppos, dir);
+      selection_end_i = tagged.cursorToIndex(selection_end, direction_of(selection_start, selection_end));
     } else if (selection_start_i >= sepend && selection_end_i < sepend) {
         // not on same side, move selection end after sep
-      selection_end   = index_to_cursor(val, sepend, dir);
-      selection_end_i = cursor_to_index(val, selection_end, direction_of(selection_start, selection_end));
+      selection_end   = tagged.indexToCursor(sepend, dir);
+      selection_end_i = tagged.cursorToIndex(selection_end, direction_of(selection_start, selection_end));
     }
     // find next separator
     seppos = val.find(_("<sep"), seppos + 1);
@@ -1123,7 +1131,7 @@ size_t TextValueEditor::prevCharBoundary(size_t pos) const {
   return max(0, (int)pos - 1);
 }
 size_t TextValueEditor::nextCharBoundary(size_t pos) const {
-  return min(index_to_cursor(value().value(), String::npos), pos + 1);
+  return min(taggedValue().cursorCount(), pos + 1);
 }
 
 static const Char word_bound_chars[] = _(" ,.:;()\n");
@@ -1225,8 +1233,8 @@ bool TextValueEditor::matchSubstr(const String& s, size_t pos, FindInfo& find) {
     editor().select(this);
     editor().SetFocus();
     size_t old_sel_start = selection_start, old_sel_end = selection_end;
-    selection_start_i = untagged_to_index(value().value(), pos,                            true);
-    selection_end_i   = untagged_to_index(value().value(), pos + find.findString().size(), true);
+    selection_start_i = taggedValue().untaggedToIndex(pos,                            true);
+    selection_end_i   = taggedValue().untaggedToIndex(pos + find.findString().size(), true);
     fixSelection(TYPE_INDEX);
     was_selection = old_sel_start == selection_start && old_sel_end == selection_end;
   }
@@ -1239,10 +1247,11 @@ bool TextValueEditor::matchSubstr(const String& s, size_t pos, FindInfo& find) {
 }
 
 bool TextValueEditor::search(FindInfo& find, bool from_start) {
-  String v = untag(value().value());
+  const TaggedText& tagged = taggedValue();
+  String v = tagged.untagged();
   if (!find.caseSensitive()) v.LowerCase();
-  size_t selection_min = index_to_untagged(value().value(), min(selection_start_i, selection_end_i));
-  size_t selection_max = index_to_untagged(value().value(), max(selection_start_i, selection_end_i));
+  size_t selection_min = tagged.indexToUntagged(min(selection_start_i, selection_end_i));
+  size_t selection_max = tagged.indexToUntagged(max(selection_start_i, selection_end_i));
   if (find.forward()) {
     size_t start = min(v.size(), find.searchSelection() ? selection_min : selection_max);
     for (size_t i = start ; i + find.findString().size() <= v.size() ; ++i) {
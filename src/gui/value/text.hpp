@@ -105,6 +105,10 @@ private:
   TextValueEditorScrollBar* scrollbar;       ///< Scrollbar for multiline fields in native look
   bool scroll_with_cursor;                   ///< When the cursor moves, should the scrollposition change?
   vector<WordListPosP> word_lists;           ///< Word lists in the text
+  mutable TaggedText tagged_value;           ///< Index of the tags in the value, for cursor movement
+  
+  /// The value with an index of its tags, reparsed when the value has changed
+  const TaggedText& taggedValue() const;
   
   // --------------------------------------------------- : Selection / movement
   
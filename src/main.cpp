@@ -14,7 +14,9 @@
 #include <data/settings.hpp>
 #include <data/locale.hpp>
 #include <data/installer.hpp>
+#include <data/pack.hpp>
 #include <data/format/formats.hpp>
+#include <gfx/image_cache.hpp>
 #include <cli/cli_main.hpp>
 #include <cli/text_io_handler.hpp>
 #include <gui/welcome_window.hpp>
@@ -27,8 +29,11 @@
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
 #include <wx/socket.h>
+#include <wx/cmdline.h>
+#include <wx/stopwatch.h>
 
 ScriptValueP export_set(SetP const& set, vector<CardP> const& cards, ExportTemplateP const& exp, String const& outname);
+String read_utf8_line(wxInputStream& input, bool until_eof = false);
 
 // ----------------------------------------------------------------------------- : Main function/class
 
@@ -76,6 +81,143 @@ void nag_about_ascii_version() {
   #endif
 }
 
+// ----------------------------------------------------------------------------- : Command line progress
+
+/// Show progress of an export on the command line
+class CLIProgress : public WithProgress {
+public:
+  void onProgress(float progress, const String& message) override {
+    if (message.empty()) return;
+    cli << GRAY << String::Format(_("[%3d%%] "), int(progress * 100)) << NORMAL << message << ENDL;
+    cli.flush();
+  }
+};
+
+// ----------------------------------------------------------------------------- : Export commands
+
+/// Run one of the export commands, with the same arguments as on the command line
+/** Returns false if args is not an export command, throws on errors.
+ */
+bool run_export_command(const vector<String>& args) {
+  if (args.empty()) return false;
+  const String& arg = args[0];
+  if (arg == _("--export-images")) {
+    if (args.size() < 2) {
+      throw Error(_("No input file specified for --export-images"));
+    }
+    SetP set = import_set(args[1]);
+    String out = args.size() >= 3 && !starts_with(args[2], _("--")) ? args[2] : String();
+    CLIProgress progress;
+    export_images(set, out, &progress);
+    return true;
+  } else if (arg == _("--export-stats")) {
+    if (args.size() < 2) {
+      throw Error(_("No input set file specified for --export-stats"));
+    }
+    SetP set = import_set(args[1]);
+    String out;
+    bool json = false, csv = false;
+    for (size_t i = 2 ; i < args.size() ; ++i) {
+      if      (args[i] == _("--json")) json = true;
+      else if (args[i] == _("--csv"))  csv  = true;
+      else out = args[i];
+    }
+    if (!json && !csv) json = wxFileName(out).GetExt().Lower() == _("json");
+    String result = export_statistics(set, json);
+    if (out.empty()) {
+      cli << result;
+    } else {
+      wxFileOutputStream file(out);
+      if (!file.IsOk()) throw Error(_("Unable to open output file: ") + out);
+      wxTextOutputStream stream(file, wxEOL_NATIVE, wxConvUTF8);
+      stream.WriteString(result);
+    }
+    return true;
+  } else if (arg == _("--simulate-packs")) {
+    if (args.size() < 3) {
+      throw Error(_("Usage: --simulate-packs SETFILE PACK [COUNT] [--seed SEED]"));
+    }
+    SetP set = import_set(args[1]);
+    String pack = args[2];
+    unsigned long count = 100000, seed = 0;
+    for (size_t i = 3 ; i < args.size() ; ++i) {
+      if (args[i] == _("--seed") && i + 1 < args.size()) {
+        if (!args[++i].ToULong(&seed)) throw Error(_("Invalid seed: ") + args[i]);
+      } else if (!args[i].ToULong(&count)) {
+        throw Error(_("Invalid number of packs: ") + args[i]);
+      }
+    }
+    PackSimulation simulation = simulate_packs(set, pack, count, (unsigned)seed);
+    cli << export_pack_simulation(set, simulation);
+    return true;
+  } else if (arg == _("--export")) {
+    if (args.size() < 2) {
+      throw Error(_("No export template specified for --export"));
+    } else if (args.size() < 3) {
+      throw Error(_("No input set file specified for --export"));
+    }
+    String export_template = args[1];
+    ExportTemplateP exp = ExportTemplate::byName(export_template);
+    SetP set = import_set(args[2]);
+    String out = args.size() >= 4 ? args[3] : _("");
+    ScriptValueP result = export_set(set, set->cards, exp, out);
+    if (out.empty()) {
+      cli << result->toString();
+    }
+    return true;
+  }
+  return false;
+}
+
+/// Run all export commands in a manifest file, and report how long each of them took
+/** The manifest has one command per line, with the same syntax as on the command line.
+ *  Empty lines and lines starting with '#' are ignored.
+ *  Games, stylesheets and export templates are loaded once and shared by all commands.
+ *  Returns false if any of the commands failed.
+ */
+bool run_batch(const String& manifest) {
+  wxFileInputStream file(manifest);
+  if (!file.IsOk()) throw Error(_("Unable to open manifest file: ") + manifest);
+  eat_utf8_bom(file);
+  struct JobResult {
+    String command;
+    long   time; // in milliseconds
+    bool   ok;
+  };
+  vector<JobResult> results;
+  wxStopWatch total;
+  while (!file.Eof()) {
+    String line = trim(read_utf8_line(file));
+    if (line.empty() || starts_with(line, _("#"))) continue;
+    wxArrayString parts = wxCmdLineParser::ConvertStringToArgs(line, wxCMD_LINE_SPLIT_UNIX);
+    vector<String> args(parts.begin(), parts.end());
+    wxStopWatch timer;
+    bool ok = false;
+    try {
+      if (!run_export_command(args)) {
+        throw Error(_("Not an export command: ") + line);
+      }
+      ok = true;
+    } catch (const Error& e) {
+      handle_error(e);
+    }
+    cli.print_pending_errors();
+    results.push_back(JobResult{line, timer.Time(), ok});
+  }
+  // report
+  size_t failed = 0;
+  cli << ENDL << BRIGHT << _("Batch report") << NORMAL << ENDL;
+  FOR_EACH(r, results) {
+    if (!r.ok) ++failed;
+    cli << (r.ok ? _("  ok    ") : _("  FAIL  "))
+        << GRAY << String::Format(_("%8.3fs  "), r.time / 1000.0) << NORMAL
+        << r.command << ENDL;
+  }
+  cli << String::Format(_("%d jobs, %d failed, %.3fs in total"), (int)results.size(), (int)failed, total.Time() / 1000.0) << ENDL;
+  cli.flush();
+  return failed == 0;
+}
+
 // ----------------------------------------------------------------------------- : Initialization
 
 int MSE::OnRun() {
@@ -94,6 +236,7 @@ int MSE::OnRun() {
     cli.init();
     package_manager.init();
     settings.read();
+    image_cache.setBudget(settings.image_cache_size * 1024 * 1024);
     the_locale = Locale::byName(settings.locale);
     nag_about_ascii_version();
     
@@ -188,9 +331,25 @@ int MSE::OnRun() {
           cli << _("\n\n  ") << BRIGHT << _("--export") << NORMAL << PARAM << _(" TEMPLATE SETFILE ") << NORMAL << _(" [") << PARAM << _("OUTFILE") << NORMAL << _("]");
           cli << _("\n         \tExport a set using an export template.");
           cli << _("\n         \tIf no output filename is specified, the result is written to stdout.");
+          cli << _("\n\n  ") << BRIGHT << _("--export-stats") << NORMAL << PARAM << _(" SETFILE") << NORMAL << _(" [") << PARAM << _("OUTFILE") << NORMAL << _("] [")
+                             << BRIGHT << _("--csv") << NORMAL << _(" | ") << BRIGHT << _("--json") << NORMAL << _("]");
+          cli << _("\n         \tExport the statistics of a set, for all categories of the game.");
+          cli << _("\n         \tValues are grouped and ordered as in the statistics panel.");
+          cli << _("\n         \tThe output is CSV, unless --json is passed or OUTFILE ends in .json.");
+          cli << _("\n         \tIf no output filename is specified, the result is written to stdout.");
           cli << _("\n\n  ") << BRIGHT << _("--export-images") << NORMAL << PARAM << _(" FILE") << NORMAL << _(" [") << PARAM << _("IMAGE") << NORMAL << _("]");
           cli << _("\n         \tExport the cards in a set to image files,");
           cli << _("\n         \tIMAGE is the same format as for 'export all card images'.");
+          cli << _("\n\n  ") << BRIGHT << _("--simulate-packs") << NORMAL << PARAM << _(" SETFILE PACK") << NORMAL << _(" [") << PARAM << _("COUNT") << NORMAL << _("] [")
+                             << BRIGHT << _("--seed") << NORMAL << PARAM << _(" SEED") << NORMAL << _("]");
+          cli << _("\n         \tGenerate COUNT packs (default 100000) of the given pack type,");
+          cli << _("\n         \tand write how often each card occurs as CSV to stdout.");
+          cli << _("\n         \tThe result is the same for the same seed.");
+          cli << _("\n\n  ") << BRIGHT << _("--batch") << NORMAL << PARAM << _(" MANIFEST") << NORMAL;
+          cli << _("\n         \tRun the export commands listed in the manifest file, one per line,");
+          cli << _("\n         \tfor example: ") << BRIGHT << _("--export-images") << NORMAL << PARAM << _(" FILE IMAGE") << NORMAL << _(".");
+          cli << _("\n         \tGames and stylesheets are only loaded once for all commands.");
+          cli << _("\n         \tAfterwards the time taken by each command is reported.");
           cli << _("\n\n  ") << BRIGHT << _("--cli") << NORMAL << _(" [")
                              << PARAM << _("FILE") << NORMAL << _("] [")
                              << BRIGHT << _("--quiet") << NORMAL << _("] [")
@@ -205,6 +364,7 @@ int MSE::OnRun() {
           cli << _("\n        - A line with an integer status code, 0 for ok, 1 for warnings, 2 for errors");
           cli << _("\n        - A line containing an integer k, the number of lines to follow");
           cli << _("\n        - k lines, each containing UTF-8 encoded string data.");
+          cli << _("\n    - Sets loaded with :load stay open, so a single process can serve many requests.");
           cli << ENDL;
           cli.flush();
           return EXIT_SUCCESS;
@@ -232,41 +392,12 @@ int MSE::OnRun() {
           }
           CLISetInterface cli_interface(set,quiet);
           return EXIT_SUCCESS;
-        } else if (arg == _("--export-images")) {
-          if (args.size() < 2) {
-            handle_error(Error(_("No input file specified for --export")));
-            return EXIT_FAILURE;
-          }
-          SetP set = import_set(args[1]);
-          // path
-          String out = args.size() >= 3 && !starts_with(args[2], _("--"))
-            ? args[2]
-            : settings.gameSettingsFor(*set->game).images_export_filename;
-          String path = _(".");
-          size_t pos = out.find_last_of(_("/\\"));
-          if (pos != String::npos) {
-            path = out.substr(0, pos);
-            if (!wxDirExists(path)) wxMkdir(path);
-            path += _("/x");
-            out = out.substr(pos + 1);
-          }
-          // export
-          export_images(set, set->cards, path, out, CONFLICT_NUMBER_OVERWRITE);
-          return EXIT_SUCCESS;
-        } else if (args[0] == _("--export")) {
+        } else if (arg == _("--batch")) {
           if (args.size() < 2) {
-            throw Error(_("No export template specified for --export"));
-          } else if (args.size() < 3) {
-            throw Error(_("No input set file specified for --export"));
-          }
-          String export_template = args[1];
-          ExportTemplateP exp = ExportTemplate::byName(export_template);
-          SetP set = import_set(args[2]);
-          String out = args.size() >= 4 ? args[3] : _("");
-          ScriptValueP result = export_set(set, set->cards, exp, out);
-          if (out.empty()) {
-            cli << result->toString();
+            throw Error(_("No manifest file specified for --batch"));
           }
+          return run_batch(args[1]) ? EXIT_SUCCESS : EXIT_FAILURE;
+        } else if (run_export_command(args)) {
           return EXIT_SUCCESS;
         } else {
           handle_error(_("Invalid command line argument:\n") + arg);
@@ -285,6 +416,8 @@ int MSE::OnRun() {
 
 int MSE::runGUI() {
   //check_updates(); // FIXME: Disable update checking on startup. Likely want to either replace the Update Checker or remove it entirely.
+  // don't block the editor on the spelling dictionaries
+  SpellChecker::use_background_thread = true;
   return wxApp::OnRun();
 }
 
@@ -70,7 +70,16 @@ void DataViewer::draw(RotatedDC& dc, const Color& background) {
   }
 }
 void DataViewer::drawViewer(RotatedDC& dc, ValueViewer& v) {
-  v.draw(dc);
+  drawLayered(dc, v);
+}
+
+void DataViewer::drawLayered(RotatedDC& dc, ValueViewer& v) {
+  v.text_layer.begin(dc.getZoom(), dc.getAngle());
+  {
+    WITH_DYNAMIC_ARG(drawing_text_layer, &v.text_layer);
+    v.draw(dc);
+  }
+  v.text_layer.end();
 }
 
 void DataViewer::updateStyles(bool only_content_dependent) {
@@ -211,9 +220,9 @@ void DataViewer::onAction(const Action& action, bool undone) {
     if (action.card == card.get()) {
       FOR_EACH(v, viewers) {
         if (v->getValue()->equals( action.valueP.get() )) {
-          // refresh the viewer
+          // refresh the viewer, only its area needs to be redrawn
           v->onAction(action, undone);
-          onChange();
+          redraw(*v);
           return;
         }
       }
@@ -223,9 +232,9 @@ void DataViewer::onAction(const Action& action, bool undone) {
     if (action.card == card.get()) {
       FOR_EACH(v, viewers) {
         if (v->getValue().get() == action.value) {
-          // refresh the viewer
+          // refresh the viewer, only its area needs to be redrawn
           v->onAction(action, undone);
-          onChange();
+          redraw(*v);
           return;
         }
       }
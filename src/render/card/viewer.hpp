@@ -35,6 +35,8 @@ public:
   virtual void draw(RotatedDC& dc, const Color& background);
   /// Draw a single viewer
   virtual void drawViewer(RotatedDC& dc, ValueViewer& v);
+  /// Draw a single viewer, reusing the text it drew the previous time
+  void drawLayered(RotatedDC& dc, ValueViewer& v);
   
   // --------------------------------------------------- : Utility for ValueViewers
   
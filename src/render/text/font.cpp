@@ -27,24 +27,33 @@ void FontTextElement::draw(RotatedDC& dc, double scale, const RealRect& rect, co
 void FontTextElement::getCharInfo(RotatedDC& dc, double scale, vector<CharInfo>& out) const {
   // font
   dc.SetFont(*font, scale);
-  // find sizes & breaks
-  double prev_width = 0;
+  // find sizes & breaks, a line at a time
+  vector<double> widths;
   size_t line_start = start; // start of the current line
-  for (size_t i = start ; i < end ; ++i) {
-    Char c = content.GetChar(i - this->start);
-    if (c == _('\n')) {
+  while (line_start < end) {
+    size_t line_end = line_start;
+    while (line_end < end && content.GetChar(line_end - this->start) != _('\n')) ++line_end;
+    if (line_end > line_start) {
+      // measure the widths of all prefixes of the line at once
+      String line = content.substr(line_start - this->start, line_end - line_start);
+      RealSize line_size = dc.GetPartialTextExtents(line, widths);
+      double prev_width = 0;
+      for (size_t i = line_start ; i < line_end ; ++i) {
+        Char c = content.GetChar(i - this->start);
+        double width = widths[i - line_start];
+        out.push_back(CharInfo(
+                         RealSize(width - prev_width, line_size.height),
+                         c == _(' ') ? LineBreak::SPACE : LineBreak::MAYBE,
+                         draw_as == DRAW_ACTIVE // from <soft> tag
+                     ));
+        prev_width = width;
+      }
+    }
+    if (line_end < end) {
+      // the line ends with a newline
       out.push_back(CharInfo(RealSize(0, dc.GetCharHeight()), break_style, draw_as == DRAW_ACTIVE));
-      line_start = i + 1;
-      prev_width = 0;
-    } else {
-      RealSize s = dc.GetTextExtent(content.substr(line_start - this->start, i - line_start + 1));
-      out.push_back(CharInfo(
-                       RealSize(s.width - prev_width, s.height),
-                       c == _(' ') ? LineBreak::SPACE : LineBreak::MAYBE,
-                       draw_as == DRAW_ACTIVE // from <soft> tag
-                   ));
-      prev_width = s.width;
     }
+    line_start = line_end + 1;
   }
 }
 
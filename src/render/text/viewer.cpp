@@ -67,7 +67,7 @@ size_t TextViewer::Line::posToIndex(double x) const {
 // ----------------------------------------------------------------------------- : TextViewer
 
 // can't be declared in header because we need to know sizeof(Line)
-TextViewer:: TextViewer() {}
+TextViewer:: TextViewer() : scale(1.0), layout_attempts(0) {}
 TextViewer::~TextViewer() {}
 
 // ----------------------------------------------------------------------------- : Drawing
@@ -166,8 +166,14 @@ bool TextViewer::prepare(RotatedDC& dc, const String& text, TextStyle& style, Co
 void TextViewer::reset(bool related) {
   elements.clear();
   lines.clear();
+  reflow.valid = false;
   if (!related) scale = 1.0;
 }
+void TextViewer::resetEdited() {
+  elements.clear();
+  lines.clear();
+  reflow.valid = !reflow.lines.empty();
+}
 bool TextViewer::prepared() const {
   return !lines.empty();
 }
@@ -394,6 +400,14 @@ void TextViewer::prepareLines(RotatedDC& dc, const String& text, TextStyle& styl
   prepareLinesTryScales(dc, text, style, chars);
   assert(!lines.empty());
   
+  // remember the layout, so after an edit only the paragraphs after it have to be layed out again
+  reflow.valid      = false;
+  reflow.scale      = scale;
+  reflow.size       = dc.getInternalSize();
+  reflow.chars      = chars;
+  reflow.paragraphs = elements.paragraphs;
+  reflow.lines      = lines;
+  
   // no text, find a dummy height for the single line we have
   if (lines.size() == 1 && lines[0].width() < 0.0001) {
     if (style.always_symbol && style.symbol_font.valid()) {
@@ -441,16 +455,30 @@ inline double bound_on_min_scale(RotatedDC& dc, const TextStyle& style, const ve
   if (height < 1) return 0.0;
   return scale * tot_height / height;
 }
+// estimate of the scale at which the text exactly fits, given the lines at scale
+// both the width of the text and the height of the lines scale linearly, so the height of the text scales quadratically
+inline double estimate_fitting_scale(RotatedDC& dc, const TextStyle& style, const vector<TextViewer::Line>& lines, double scale) {
+  if (lines.empty()) return scale;
+  double tot_height = dc.getInternalSize().height;
+  double height = lines.back().bottom() + style.padding_bottom;
+  if (height < 1) return scale;
+  return scale * sqrt(tot_height / height);
+}
 
 void TextViewer::prepareLinesTryScales(RotatedDC& dc, const String& text, const TextStyle& style, vector<CharInfo>& chars) {
+  layout_attempts = 0;
   // Bounds
   double min_scale = elements.minScale();
   double scale_step = max(0.01,elements.scaleStep());
+  // After an edit, the text usually still fits at full size
+  if (reflow.valid && (min_scale >= 1.0 || scale >= 1.0)) {
+    if (tryReflow(dc, style, chars)) return;
+    chars.clear();
+  }
   // Is there any scaling (common case is: no)
   if (min_scale >= 1.0) {
     scale = 1.0;
-    elements.getCharInfo(dc, scale, chars);
-    prepareLinesAtScale(dc, chars, style, false, lines);
+    tryScale(dc, style, scale, chars, lines);
     return;
   }
   
@@ -471,8 +499,7 @@ void TextViewer::prepareLinesTryScales(RotatedDC& dc, const String& text, const
   //           - change max_scale  
   
   // Try the layout at the previous scale, this could give a quick upper bound
-  elements.getCharInfo(dc, scale, chars);
-  bool fits = prepareLinesAtScale(dc, chars, style, false, lines);
+  bool fits = tryScale(dc, style, scale, chars, lines);
   if (fits) {
     min_scale = scale;
     max_scale = min(max_scale, bound_on_max_scale(dc,style,lines,scale));
@@ -482,8 +509,7 @@ void TextViewer::prepareLinesTryScales(RotatedDC& dc, const String& text, const
     scale += scale_step;
     vector<Line> lines_before;
     vector<CharInfo> chars_before;
-    elements.getCharInfo(dc, scale, chars_before);
-    fits = prepareLinesAtScale(dc, chars_before, style, false, lines_before);
+    fits = tryScale(dc, style, scale, chars_before, lines_before);
     if (fits) {
       // too bad
       swap(lines, lines_before);
@@ -500,27 +526,29 @@ void TextViewer::prepareLinesTryScales(RotatedDC& dc, const String& text, const
     min_scale = max(min_scale, bound_on_min_scale(dc,style,lines,scale));
     // ensure invariant d (below)
     best_scale = scale = min_scale;
-    chars.clear();
-    elements.getCharInfo(dc, scale, chars);
-    prepareLinesAtScale(dc, chars, style, false, lines);
+    tryScale(dc, style, scale, chars, lines);
     max_scale = min(max_scale, bound_on_max_scale(dc,style,lines,scale));
   }
   
-  // The common case optimization failed, try a binary search
+  // The common case optimization failed, search for the largest scale that fits
   // Invariant:
   //    a. The text fits at min_scale (or we force it anyway)
   //    b. but not at max_scale
   //    c. 0 < min_scale <= real_scale < max_scale <= 1.0+epsilon
   //    d. lines and chars give the best fitting positioning, at best_scale
   //    try: e. min_scale <= best_scale
-    
-  // go binary search!
+  //
+  // Instead of always bisecting, we aim for the scale where the text is estimated to fit exactly,
+  // based on the last attempt. This is usually very close, so the search ends after one or two more attempts.
+  // The estimate is kept in the middle half of the interval, so the interval still shrinks by at least a quarter.
+  double estimate = estimate_fitting_scale(dc,style,lines,best_scale);
   while(min_scale + scale_step < max_scale) {
-    scale = (min_scale + max_scale) / 2;
+    double quarter = (max_scale - min_scale) / 4;
+    scale = max(min_scale + quarter, min(max_scale - quarter, estimate));
     vector<Line> lines_try;
     vector<CharInfo> chars_try;
-    elements.getCharInfo(dc, scale, chars_try);
-    fits = prepareLinesAtScale(dc, chars_try, style, false, lines_try);
+    fits = tryScale(dc, style, scale, chars_try, lines_try);
+    estimate = estimate_fitting_scale(dc,style,lines_try,scale);
     if (fits) {
       min_scale = scale;
       max_scale = min(max_scale, bound_on_max_scale(dc,style,lines_try,scale));
@@ -536,13 +564,52 @@ void TextViewer::prepareLinesTryScales(RotatedDC& dc, const String& text, const
   if (best_scale != min_scale) {
     // we'd better update lines, e doesn't hold
     scale = min_scale;
-    chars.clear();
-    elements.getCharInfo(dc, scale, chars);
-    fits = prepareLinesAtScale(dc, chars, style, false, lines);
+    tryScale(dc, style, scale, chars, lines);
   }
   scale = min_scale;
 }
 
+bool TextViewer::tryScale(RotatedDC& dc, const TextStyle& style, double try_scale, vector<CharInfo>& chars, vector<Line>& lines) {
+  layout_attempts += 1;
+  chars.clear();
+  elements.getCharInfo(dc, try_scale, chars);
+  return prepareLinesAtScale(dc, chars, style, false, lines);
+}
+
+inline bool same_char(const CharInfo& a, const CharInfo& b) {
+  return a.size.width == b.size.width && a.size.height == b.size.height
+      && a.break_after == b.break_after && a.soft == b.soft;
+}
+inline bool same_paragraph(const TextParagraph& a, const TextParagraph& b) {
+  return a.start == b.start && a.end == b.end && a.margin_end_char == b.margin_end_char
+      && a.margin_left == b.margin_left && a.margin_right == b.margin_right && a.margin_top == b.margin_top
+      && a.alignment == b.alignment;
+}
+
+bool TextViewer::tryReflow(RotatedDC& dc, const TextStyle& style, vector<CharInfo>& chars) {
+  RealSize size = dc.getInternalSize();
+  if (reflow.scale != scale || reflow.size.width != size.width || reflow.size.height != size.height) return false;
+  // measuring is cheap for the unchanged parts of the text, since the extents are cached
+  elements.getCharInfo(dc, scale, chars);
+  // find the first paragraph that changed
+  const vector<TextParagraph>& paragraphs = elements.paragraphs;
+  size_t p = 0;
+  for ( ; p + 1 < paragraphs.size() && p + 1 < reflow.paragraphs.size() ; ++p) {
+    const TextParagraph& para = paragraphs[p];
+    if (!same_paragraph(para, reflow.paragraphs[p])) break;
+    if (para.end > chars.size() || para.end > reflow.chars.size()) break;
+    if (!equal(chars.begin() + para.start, chars.begin() + para.end, reflow.chars.begin() + para.start, same_char)) break;
+  }
+  // keep the lines before that paragraph
+  size_t keep = 0;
+  if (p > 0) {
+    while (keep < reflow.lines.size() && reflow.lines[keep].start < paragraphs[p].start) ++keep;
+  }
+  layout_attempts += 1;
+  swap(lines, reflow.lines);
+  return prepareLinesAtScale(dc, chars, style, false, lines, keep, p);
+}
+
 // Try to fit a blank line in the masked image, move down until it fits
 RealSize TextViewer::fitLineWidth(Line& line, RotatedDC& dc, const TextStyle& style) const {
   RealSize line_size(line.margin_left + lineLeft(dc, style, line.top), 0);
@@ -554,20 +621,38 @@ RealSize TextViewer::fitLineWidth(Line& line, RotatedDC& dc, const TextStyle& st
   return line_size;
 }
 
-bool TextViewer::prepareLinesAtScale(RotatedDC& dc, const vector<CharInfo>& chars, const TextStyle& style, bool stop_if_too_long, vector<Line>& lines) const {
-  // Try to layout the text at the current scale
-  lines.clear();
+// spacing after a line that ends in the given way
+inline double line_height_multiplier(const TextStyle& style, LineBreak break_after) {
+  return break_after == LineBreak::HARD ? style.line_height_hard
+       : break_after == LineBreak::LINE ? style.line_height_line
+       :                                  style.line_height_soft;
+}
 
-  // The current "paragraph" in the input string
-  size_t i_para = 0;
+bool TextViewer::prepareLinesAtScale(RotatedDC& dc, const vector<CharInfo>& chars, const TextStyle& style, bool stop_if_too_long, vector<Line>& lines,
+                                     size_t keep_lines, size_t resume_paragraph) const {
+  // Try to layout the text at the current scale
   assert(elements.paragraphs.size() > 0);
-
-  // first line
   Line line;
-  line.top = style.padding_top;
-  line.margin_left  = elements.paragraphs[0].margin_left;
-  line.margin_right = elements.paragraphs[0].margin_right;
-  line.alignment = elements.paragraphs[0].alignment;
+  size_t i_para = 0; // The current "paragraph" in the input string
+  size_t i_start = 0;
+  if (keep_lines > 0 && keep_lines <= lines.size() && resume_paragraph < elements.paragraphs.size()) {
+    // continue at the start of a paragraph, in the same state as if we had just layed out the lines before it
+    lines.resize(keep_lines);
+    const Line& prev = lines.back();
+    i_para  = resume_paragraph;
+    i_start = elements.paragraphs[i_para].start;
+    line.start       = i_start;
+    line.end_or_soft = prev.end_or_soft;
+    line.top         = prev.top + prev.line_height * line_height_multiplier(style, prev.break_after) + elements.paragraphs[i_para].margin_top;
+    line.line_height = prev.break_after == LineBreak::LINE ? 0 : prev.line_height;
+  } else {
+    // first line
+    lines.clear();
+    line.top = style.padding_top;
+  }
+  line.margin_left  = elements.paragraphs[i_para].margin_left;
+  line.margin_right = elements.paragraphs[i_para].margin_right;
+  line.alignment = elements.paragraphs[i_para].alignment;
   // size of the line so far
   RealSize line_size = fitLineWidth(line, dc, style);
   line.positions.push_back(line_size.width);
@@ -576,9 +661,9 @@ bool TextViewer::prepareLinesAtScale(RotatedDC& dc, const vector<CharInfo>& char
   RealSize       word_size;
   vector<double> positions_word; // positios for this word
   size_t         word_end_or_soft = 0;
-  size_t         word_start = 0;
+  size_t         word_start = i_start;
   // For each character ...
-  for (size_t i = 0 ; i < chars.size() ; ++i) {
+  for (size_t i = i_start ; i < chars.size() ; ++i) {
     const CharInfo& c = chars[i];
     assert(i_para < elements.paragraphs.size());
     assert(c.size.width == 0 || elements.paragraphs[i_para].start <= i && i < elements.paragraphs[i_para].end);
@@ -675,10 +760,7 @@ bool TextViewer::prepareLinesAtScale(RotatedDC& dc, const vector<CharInfo>& char
       // push
       lines.push_back(line);
       // reset line object for next line
-      double line_height_multiplier = line.break_after == LineBreak::HARD ? style.line_height_hard
-                                    : line.break_after == LineBreak::LINE ? style.line_height_line
-                                    :                                       style.line_height_soft;
-      line.top += line.line_height * line_height_multiplier;
+      line.top += line.line_height * line_height_multiplier(style, line.break_after);
       line.start = word_start;
       line.positions.clear();
       if (line.break_after == LineBreak::LINE) line.line_height = 0;
@@ -872,3 +954,29 @@ void TextViewer::Line::alignHorizontal(const vector<CharInfo>& chars, const Text
     }
   }
 }
+
+// ----------------------------------------------------------------------------- : TextLayoutStats
+
+TextLayoutStats text_layout_stats;
+
+void TextLayoutStats::add(const String& field, int attempts) {
+  wxMutexLocker lock(mutex);
+  Field& f = stats[field];
+  f.name = field;
+  f.layouts      += 1;
+  f.attempts     += attempts;
+  f.max_attempts  = max(f.max_attempts, (size_t)attempts);
+}
+
+vector<TextLayoutStats::Field> TextLayoutStats::fields() {
+  wxMutexLocker lock(mutex);
+  vector<Field> out;
+  FOR_EACH(s, stats) out.push_back(s.second);
+  sort(out.begin(), out.end(), [](const Field& a, const Field& b) { return a.attempts > b.attempts; });
+  return out;
+}
+
+void TextLayoutStats::clear() {
+  wxMutexLocker lock(mutex);
+  stats.clear();
+}
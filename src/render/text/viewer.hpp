@@ -59,8 +59,15 @@ public:
   /** If related, the new value is related to the old one, and layout information should be reused where possible
    */
   void reset(bool related);
+  /// Reset the cached data after the text was edited
+  /** Like reset(true), but the layout of the paragraphs before the edit can be reused,
+   *  as long as the text doesn't have to be scaled differently.
+   */
+  void resetEdited();
   /// Is the viewer prepare()d?
   bool prepared() const;
+  /// Number of times the text was layed out during the last prepare, to find the scale
+  inline int layoutAttempts() const { return layout_attempts; }
   
   // --------------------------------------------------- : Positions
   
@@ -123,6 +130,7 @@ private:
 private:
   // --------------------------------------------------- : More drawing
   double scale;    ///< Scale when drawing
+  int layout_attempts; ///< Number of calls to tryScale in the last prepare
   
   // --------------------------------------------------- : Elements
   TextElements elements; ///< The elements of the prepared text
@@ -138,8 +146,29 @@ private:
   /// Find the scale to use for the text
   void prepareLinesTryScales(RotatedDC& dc, const String& text, const TextStyle& style, vector<CharInfo>& chars_out);
   /// Prepare the lines, layout the text; at a specific scale
-  /** Stores output in lines_out */
-  bool prepareLinesAtScale(RotatedDC& dc, const vector<CharInfo>& chars, const TextStyle& style, bool stop_if_too_long, vector<Line>& lines_out) const;
+  /** Stores output in lines_out.
+   *  If keep_lines > 0, then the first keep_lines lines of lines_out are kept, and they must
+   *  be exactly the lines before paragraph resume_paragraph.
+   */
+  bool prepareLinesAtScale(RotatedDC& dc, const vector<CharInfo>& chars, const TextStyle& style, bool stop_if_too_long, vector<Line>& lines_out,
+                           size_t keep_lines = 0, size_t resume_paragraph = 0) const;
+  /// Measure the text and lay it out at the given scale, returns true if it fits
+  bool tryScale(RotatedDC& dc, const TextStyle& style, double scale, vector<CharInfo>& chars_out, vector<Line>& lines_out);
+  
+  /// The layout from the previous prepare, before alignment
+  struct Reflow {
+    bool                  valid = false; ///< Can the layout be reused? Only after an edit
+    double                scale = 0;
+    RealSize              size;          ///< Internal size of the dc
+    vector<CharInfo>      chars;
+    vector<TextParagraph> paragraphs;
+    vector<Line>          lines;
+  };
+  Reflow reflow;
+  
+  /// After an edit, lay out the text again starting from the first paragraph that changed
+  /** Only possible if the text still fits at the same scale, returns false if it doesn't */
+  bool tryReflow(RotatedDC& dc, const TextStyle& style, vector<CharInfo>& chars_out);
   /// Move the line down until it fits in the masked area
   /// Return the line's size
   RealSize fitLineWidth(Line& line, RotatedDC& dc, const TextStyle& style) const;
@@ -160,4 +189,31 @@ private:
   double lineRight(RotatedDC& dc, const TextStyle& style, double y) const;
 };
 
+// ----------------------------------------------------------------------------- : TextLayoutStats
+
+/// Statistics on the number of layout attempts needed to find the scale of text fields
+/** Boxes that have to shrink their text need several attempts,
+ *  these statistics help template authors find the fields where that happens a lot.
+ */
+class TextLayoutStats {
+public:
+  struct Field {
+    String name;
+    size_t layouts;       ///< Number of times the field was prepared
+    size_t attempts;      ///< Total number of layout attempts
+    size_t max_attempts;  ///< Largest number of attempts for a single layout
+  };
+  
+  /// Record a layout of the given field
+  void add(const String& field, int attempts);
+  /// Statistics for all fields, the fields with the most attempts first
+  vector<Field> fields();
+  void clear();
+  
+private:
+  wxMutex mutex;
+  map<String,Field> stats;
+};
 
+/// The global layout statistics
+extern TextLayoutStats text_layout_stats;
@@ -16,13 +16,19 @@ IMPLEMENT_VALUE_VIEWER(Text);
 
 bool TextValueViewer::prepare(RotatedDC& dc) {
   getMask(dc); // ensure alpha/contour mask is loaded
-  return v.prepare(dc, value().value(), style(), getContext());
+  return prepareText(dc);
+}
+
+bool TextValueViewer::prepareText(RotatedDC& dc) {
+  if (!v.prepare(dc, value().value(), style(), getContext())) return false;
+  text_layout_stats.add(getField()->name, v.layoutAttempts());
+  return true;
 }
 
 void TextValueViewer::draw(RotatedDC& dc) {
   drawFieldBorder(dc);
   if (!v.prepared()) {
-    v.prepare(dc, value().value(), style(), getContext());
+    prepareText(dc);
     dc.setStretch(getStretch());
   }
   DrawWhat what = drawWhat();
@@ -41,7 +47,7 @@ void TextValueViewer::onStyleChange(int changes) {
 }
 
 void TextValueViewer::onAction(const Action&, bool undone) {
-  v.reset(true);
+  v.resetEdited();
 }
 
 double TextValueViewer::getStretch() const {
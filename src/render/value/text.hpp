@@ -29,6 +29,9 @@ public:
   
 protected:
   TextViewer v;
+  
+  /// Prepare the text viewer, and record how many layout attempts that took
+  bool prepareText(RotatedDC& dc);
 };
 
 
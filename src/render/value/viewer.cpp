@@ -119,8 +119,14 @@ bool ValueViewer::isCurrent() const {
 
 void ValueViewer::onStyleChange(int changes) {
   if (!(changes & CHANGE_ALREADY_PREPARED)) {
-    parent.redraw(*this);
+    parent.redraw(*this); // old area
   }
   // update bounding box
-  if (!nativeLook()) bounding_box = getStyle()->getExternalRect();
+  if (!nativeLook()) {
+    RealRect old_bounding_box = bounding_box;
+    bounding_box = getStyle()->getExternalRect();
+    if (!(changes & CHANGE_ALREADY_PREPARED) && bounding_box != old_bounding_box) {
+      parent.redraw(*this); // new area
+    }
+  }
 }
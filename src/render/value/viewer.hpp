@@ -13,6 +13,7 @@
 #include <util/real_point.hpp>
 #include <data/draw_what.hpp>
 #include <data/field.hpp>
+#include <gfx/gfx.hpp>
 
 class Set;
 class Package;
@@ -76,6 +77,7 @@ public:
 public:
   DataViewer& parent; ///< Our parent object
   RealRect bounding_box; ///< The bounding box of this viewer. Corresponds to styleP->getExternalRect(), except for native look editor
+  TextLayer text_layer; ///< The text drawn by this viewer, see DataViewer::drawLayered
 protected:
   ValueP valueP; ///< The value we are currently viewing
   
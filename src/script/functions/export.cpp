@@ -15,6 +15,7 @@
 #include <data/card.hpp>
 #include <data/export_template.hpp>
 #include <data/format/formats.hpp>
+#include <data/format/image_writer.hpp>
 #include <util/tagged_string.hpp>
 #include <gfx/generated_image.hpp>
 #include <util/error.hpp>
@@ -401,19 +402,44 @@ SCRIPT_FUNCTION(copy_file) {
 }
 
 // write a file to the destination directory
+// with append:true the text is added to a file that was written before during this export,
+// so a template can write its output card by card instead of building one big string
 SCRIPT_FUNCTION(write_text_file) {
   guard_export_info(_("write_text_file"));
   SCRIPT_PARAM_C(String, input); // text to write
   SCRIPT_PARAM(String, file); // file to write to
+  SCRIPT_OPTIONAL_PARAM_(bool, append);
   // output path
   String out_path = get_export_full_path(file);
-  // write
-  ensure_dir_valid(out_path);
-  wxFileOutputStream out(out_path);
-  if (!out.Ok()) throw Error(_("Unable to open file '") + out_path + _("' for output"));
-  wxTextOutputStream tout(out);
-  tout.WriteString(BYTE_ORDER_MARK);
-  tout.WriteString(input);
+  ExportInfo& ei = *export_info();
+  auto it = ei.text_files.find(out_path);
+  if (append && it != ei.text_files.end()) {
+    // add to a file written before during this export
+    if (!it->second) {
+      wxFile f;
+      if (!f.Open(out_path, wxFile::write_append)) {
+        throw Error(_("Unable to open file '") + out_path + _("' for output"));
+      }
+      it->second = make_unique<wxFileOutputStream>(f.Detach());
+    }
+    wxTextOutputStream tout(*it->second);
+    writeUTF8(tout, input);
+  } else {
+    // a new file, close it if it was still open for appending
+    if (it != ei.text_files.end()) it->second.reset();
+    ensure_dir_valid(out_path);
+    auto out = make_unique<wxFileOutputStream>(out_path);
+    if (!out->Ok()) throw Error(_("Unable to open file '") + out_path + _("' for output"));
+    {
+      wxTextOutputStream tout(*out);
+      tout.WriteString(BYTE_ORDER_MARK);
+      writeUTF8(tout, input);
+    }
+    // with append the file stays open until the end of the export, otherwise it is closed now,
+    // but remembered so a later append adds to it
+    if (!append) out.reset();
+    ei.text_files[out_path] = move(out);
+  }
   SCRIPT_RETURN(file);
 }
 
@@ -432,18 +458,24 @@ SCRIPT_FUNCTION(write_image_file) {
   SCRIPT_OPTIONAL_PARAM_(int, width);
   SCRIPT_OPTIONAL_PARAM_(int, height);
   ScriptObject<CardP>* card = dynamic_cast<ScriptObject<CardP>*>(input.get()); // is it a card?
-  Image image;
+  // the image is generated directly into the job, so no other reference to it remains on this thread
+  auto job = make_unique<ImageExportJob>();
   GeneratedImage::Options options(width, height, ei.export_template.get(), ei.set.get());
   if (card) {
-    image = conform_image(export_bitmap(ei.set, card->getValue()).ConvertToImage(), options);
+    job->image = conform_image(export_image(ei.set, card->getValue()), options);
   } else {
-    image = input->toImage()->generateConform(options);
+    job->image = input->toImage()->generateConform(options).Copy();
   }
-  if (!image.Ok()) throw Error(_("Unable to generate image for file ") + file);
-  // write
+  if (!job->image.Ok()) throw Error(_("Unable to generate image for file ") + file);
+  ei.exported_images.insert(make_pair(file, wxSize(job->image.GetWidth(), job->image.GetHeight())));
+  // write, in the background if possible
   ensure_dir_valid(out_path);
-  image.SaveFile(out_path);
-  ei.exported_images.insert(make_pair(file, wxSize(image.GetWidth(), image.GetHeight())));
+  job->filename = out_path;
+  if (ei.image_writer) {
+    ei.image_writer->add(move(job));
+  } else {
+    job->image.SaveFile(out_path);
+  }
   SCRIPT_RETURN(file);
 }
 
@@ -13,19 +13,37 @@
 #include <util/spell_checker.hpp>
 #include <util/tagged_string.hpp>
 #include <data/stylesheet.hpp>
+#include <data/field.hpp>
+#include <data/set.hpp>
 
 // ----------------------------------------------------------------------------- : Functions
 
-inline size_t spelled_correctly(const String& input, size_t start, size_t end, SpellChecker** checkers, const ScriptValueP& extra_test, Context& ctx) {
+// Is a word spelled correctly?
+// If background is set, words that have not been checked before are checked in the background,
+// in that case they count as correct for now, and pending is set.
+inline bool spelled_correctly(const String& input, size_t start, size_t end, SpellChecker** checkers, const ScriptValueP& extra_test, Context& ctx, bool background, bool& pending) {
   // untag
   String word = untag(input.substr(start,end-start));
   if (word.empty()) return true;
   // run through spellchecker(s)
+  bool unknown = false;
   for (size_t i = 0 ; checkers[i] ; ++i) {
-    if (checkers[i]->spell(word)) {
+    bool correct;
+    if (!background) {
+      correct = checkers[i]->spell(word);
+    } else if (!checkers[i]->spellCached(word, correct)) {
+      checkers[i]->checkInBackground(word);
+      unknown = true;
+      continue;
+    }
+    if (correct) {
       return true;
     }
   }
+  if (unknown) {
+    pending = true;
+    return true;
+  }
   // run through additional words regex
   if (extra_test) {
     // try on untagged
@@ -42,9 +60,9 @@ inline size_t spelled_correctly(const String& input, size_t start, size_t end, S
   return false;
 }
 
-void check_word(const String& tag, const String& input, size_t start, size_t end, String& out, bool check, SpellChecker** checkers, const ScriptValueP& extra_test, Context& ctx) {
+void check_word(const String& tag, const String& input, size_t start, size_t end, String& out, bool check, SpellChecker** checkers, const ScriptValueP& extra_test, Context& ctx, bool background, bool& pending) {
   if (start >= end) return;
-  bool good = !check || spelled_correctly(input, start, end, checkers, extra_test, ctx);
+  bool good = !check || spelled_correctly(input, start, end, checkers, extra_test, ctx, background, pending);
   if (!good) { out += _("<"); out += tag; }
   out.append(input, start, end-start);
   if (!good) { out += _("</"); out += tag; }
@@ -81,6 +99,12 @@ SCRIPT_FUNCTION(check_spelling) {
     tag += _(":") + extra_dictionary;
   }
   tag += _(">");
+  // when updating a value of a set, leave the words we don't know yet to the background thread,
+  // the set updates the value again when they are checked
+  SCRIPT_OPTIONAL_PARAM_C_(Set*, set);
+  Value* value = value_being_updated();
+  bool background = SpellChecker::use_background_thread && set && value && wxThread::IsMain();
+  bool pending = false;
   // now walk over the words in the input, and mark misspellings
   String result;
   size_t word_start = String::npos; // start of the word to be checked, or npos if not inside a word
@@ -116,7 +140,7 @@ SCRIPT_FUNCTION(check_spelling) {
     } else {
       // a non-word character, punctuation or space
       // check word, add to result
-      check_word(tag, input, word_start, pos, result, check_this_word, checkers, extra_match, ctx);
+      check_word(tag, input, word_start, pos, result, check_this_word, checkers, extra_match, ctx, background, pending);
       word_start = String::npos;
       check_this_word = unchecked_tag <= 0;
       result += c;
@@ -124,7 +148,10 @@ SCRIPT_FUNCTION(check_spelling) {
     }
   }
   // last word
-  check_word(tag, input, word_start, input.size(), result, check_this_word, checkers, extra_match, ctx);
+  check_word(tag, input, word_start, input.size(), result, check_this_word, checkers, extra_match, ctx, background, pending);
+  if (pending) {
+    set->updateWhenSpellChecked(value);
+  }
   // done
   assert_tagged(result);
   SCRIPT_RETURN(result);
@@ -20,6 +20,7 @@
 #include <data/action/value.hpp>
 #include <data/action/keyword.hpp>
 #include <util/error.hpp>
+#include <util/spell_checker.hpp>
 
 // ----------------------------------------------------------------------------- : SetScriptContext : initialization
 
@@ -153,6 +154,8 @@ void SetScriptManager::initDependencies(Context& ctx, StyleSheet& stylesheet) {
 void SetScriptManager::onAction(const Action& action, bool undone) {
   TYPE_CASE(action, ValueAction) {
     if (action.card) {
+      // other values of the card can depend on this one, even if their input text stays the same
+      forgetExpansions(*action.card);
       updateValue(*action.valueP, action.card);
       return;
     } else {
@@ -165,12 +168,15 @@ void SetScriptManager::onAction(const Action& action, bool undone) {
           value->update(ctx);
           // changed the 'match' string of a keyword, rebuild database and regex so matching is correct
           value->keyword.prepare(set.game->keyword_parameter_types, true);
-          set.keyword_db.clear();
+          set.keyword_db.keywordChanged(value->keyword, true);
+        } else {
+          set.keyword_db.keywordChanged(value->keyword, false);
         }
         delay |= DELAY_KEYWORDS;
         return;
       }
       // a set or styling value
+      set.keyword_db.clearExpansions();
       updateValue(*action.valueP, CardP());
     }
   }
@@ -191,6 +197,8 @@ void SetScriptManager::onAction(const Action& action, bool undone) {
     // note: fallthrough
   }
   TYPE_CASE_(action, CardListAction) {
+    set.keyword_db.clearExpansions(); // scripts can look at other cards
+    set.clearOrderCache();
     #ifdef LOG_UPDATES
       wxLogDebug(_("Card dependencies"));
     #endif
@@ -200,22 +208,35 @@ void SetScriptManager::onAction(const Action& action, bool undone) {
     #endif
   }
   TYPE_CASE_(action, KeywordListAction) {
+    set.clearOrderCache();
     updateAllDependend(set.game->dependent_scripts_keywords);
     return;
   }
-  TYPE_CASE_(action, ChangeKeywordModeAction) {
+  TYPE_CASE(action, ChangeKeywordModeAction) {
+    set.keyword_db.keywordChanged(action.keyword, false);
+    set.clearOrderCache();
     updateAllDependend(set.game->dependent_scripts_keywords);
     return;
   }
   TYPE_CASE(action, ChangeCardStyleAction) {
+    forgetExpansions(*action.card);
+    set.orderCacheChanged(action.card);
     updateAllDependend(set.game->dependent_scripts_stylesheet, action.card);
   }
   TYPE_CASE_(action, ChangeSetStyleAction) {
+    set.keyword_db.clearExpansions();
+    set.clearOrderCache();
     updateAllDependend(set.game->dependent_scripts_stylesheet);
     return;
   }
 }
 
+void SetScriptManager::forgetExpansions(const Card& card) {
+  FOR_EACH_CONST(v, card.data) {
+    set.keyword_db.forgetExpansion(v.get());
+  }
+}
+
 void SetScriptManager::updateStyles(const CardP& card, bool only_content_dependent) {
   assert(card);
   const StyleSheet& stylesheet = set.stylesheetFor(card);
@@ -226,6 +247,7 @@ void SetScriptManager::updateStyles(const CardP& card, bool only_content_depende
     FOR_EACH(v, extra_data) {
       if (v->update(ctx)) {
         // changed, send event
+        set.orderCacheChanged(card);
         ScriptValueEvent change(card.get(), v.get());
         set.actions.tellListeners(change, false);
       }
@@ -252,16 +274,42 @@ void SetScriptManager::updateStyles(Context& ctx, const IndexMap<FieldP,StyleP>&
 
 void SetScriptManager::updateDelayed() {
   if (delay & DELAY_KEYWORDS) {
+    set.clearOrderCache(); // scripts can use the keywords directly
     updateAllDependend(set.game->dependent_scripts_keywords);
   }
   delay = 0;
 }
 
+void SetScriptManager::updateWhenSpellChecked(Value* value) {
+  spelling_pending.push_back(value);
+}
+
+void SetScriptManager::updateSpellChecked() {
+  if (spelling_pending.empty() || SpellChecker::checkingInBackground()) return;
+  // only update values that are still part of the set
+  sort(spelling_pending.begin(), spelling_pending.end());
+  auto pending = [&](const ValueP& v) {
+    return binary_search(spelling_pending.begin(), spelling_pending.end(), v.get());
+  };
+  deque<ToUpdate> to_update;
+  FOR_EACH(v, set.data) {
+    if (pending(v)) to_update.push_back(ToUpdate(v.get(), CardP()));
+  }
+  FOR_EACH(card, set.cards) {
+    FOR_EACH(v, card->data) {
+      if (pending(v)) to_update.push_back(ToUpdate(v.get(), card));
+    }
+  }
+  spelling_pending.clear();
+  updateRecursive(to_update, Age());
+}
+
 void SetScriptManager::updateValue(Value& value, const CardP& card) {
   Age starting_age; // the start of the update process
   deque<ToUpdate> to_update;
   // execute script for initial changed value
   value.update(getContext(card));
+  set.orderCacheChanged(card);
   #ifdef LOG_UPDATES
     wxLogDebug(_("Start:     %s"), value.fieldP->name);
   #endif
@@ -278,12 +326,13 @@ void SetScriptManager::updateAll() {
     wxLogDebug(_("Update all"));
   #endif
   wxBusyCursor busy;
+  set.clearOrderCache();
   // update set data
   Context& ctx = getContext(set.stylesheet);
   FOR_EACH(v, set.data) {
     try {
       PROFILER2( v->fieldP.get(), _("update set.") + v->fieldP->name );
-      v->update(ctx);
+      if (v->update(ctx)) set.orderCacheChanged(CardP());
     } catch (const ScriptError& e) {
       handle_error(ScriptError(e.what() + _("\n  while updating set value '") + v->fieldP->name + _("'")));
     }
@@ -297,7 +346,7 @@ void SetScriptManager::updateAll() {
           Timer t;
           Profiler prof(t, v->fieldP.get(), _("update card.") + v->fieldP->name);
         #endif
-        v->update(ctx);
+        if (v->update(ctx)) set.orderCacheChanged(card);
       } catch (const ScriptError& e) {
         handle_error(ScriptError(e.what() + _("\n  while updating card value '") + v->fieldP->name + _("'")));
       }
@@ -319,7 +368,6 @@ void SetScriptManager::updateAllDependend(const vector<Dependency>& dependent_sc
 
 void SetScriptManager::updateRecursive(deque<ToUpdate>& to_update, Age starting_age) {
   if (to_update.empty()) return;
-  set.clearOrderCache(); // clear caches before evaluating a round of scripts
   while (!to_update.empty()) {
     updateToUpdate(to_update.front(), to_update, starting_age);
     to_update.pop_front();
@@ -337,7 +385,9 @@ void SetScriptManager::updateToUpdate(const ToUpdate& u, deque<ToUpdate>& to_upd
     handle_error(ScriptError(e.what() + _("\n  while updating value '") + u.value->fieldP->name + _("'")));
   }
   if (changes) {
-    // changed, send event
+    // changed, cards that are ordered by this value may move
+    set.orderCacheChanged(u.card);
+    // send event
     ScriptValueEvent change(u.card.get(), u.value);
     set.actions.tellListeners(change, false);
     // u.value has changed, also update values with a dependency on u.value
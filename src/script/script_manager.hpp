@@ -64,6 +64,11 @@ public:
   /// Update expensive things that were previously delayed
   void updateDelayed();
   
+  /// Update a value again once the background spell checker is done with the words it used
+  void updateWhenSpellChecked(Value* value);
+  /// Update the values waiting for the spell checker, if it is done
+  void updateSpellChecked();
+  
   /// Update all fields of all cards
   /** Update all set info fields
    *  Doesn't update styles
@@ -81,6 +86,8 @@ private:
   /// Updates scripts, starting at some value
   /** if the value changes any dependend values are updated as well */
   void updateValue(Value& value, const CardP& card);
+  /// Forget the cached keyword expansions of the values of a card
+  void forgetExpansions(const Card& card);
   // Update all values with a specific dependency
   void updateAllDependend(const vector<Dependency>& dependent_scripts, const CardP& card = CardP());
   
@@ -104,6 +111,8 @@ private:
   ,  DELAY_CARDS    = 0x02
   };
   int delay;
+  /// Values that were marked before all their words were spell checked
+  vector<Value*> spelling_pending;
   
 protected:
   /// Respond to actions by updating scripts
@@ -528,7 +528,7 @@ Package::FileInfos::iterator Package::addFile(const String& name) {
 
 DateTime Package::modificationTime(const pair<String, FileInfo>& fi) const {
   if (fi.second.wasWritten()) {
-    return wxFileName(fi.first).GetModificationTime();
+    return wxFileName(fi.second.tempName).GetModificationTime();
   } else if (fi.second.zipEntry) {
     return fi.second.zipEntry->GetDateTime();
   } else if (wxFileExists(filename+_("/")+fi.first)) {
@@ -538,6 +538,15 @@ DateTime Package::modificationTime(const pair<String, FileInfo>& fi) const {
   }
 }
 
+DateTime Package::modificationTime(const String& file) {
+  FileInfos::const_iterator it = files.find(normalize_internal_filename(file));
+  if (it != files.end()) {
+    return modificationTime(*it);
+  } else {
+    return modified;
+  }
+}
+
 
 // ----------------------------------------------------------------------------- : Packaged
 
@@ -220,6 +220,8 @@ public:
   inline const FileInfos& getFileInfos() const { return files; }
   /// When was a file last modified?
   DateTime modificationTime(const pair<String, FileInfo>& fi) const;
+  /// When was a file in the package last modified?
+  DateTime modificationTime(const String& file);
 private:
   /// All files in the package
   FileInfos files;
@@ -109,20 +109,26 @@ bool PackageManager::existsInPackage(const String& name) {
   throw FileNotFoundError(name, _("No package name specified, use '/package/filename'"));
 }
 
+PackagedP PackageManager::openPackageOf(Packaged* package, const String& name, String& name_out) {
+  if (name.empty() || name.GetChar(0) != _('/')) return PackagedP();
+  // absolute name; break name
+  size_t start = name.find_first_not_of(_("/\\"), 1); // allow "//package/name" from incorrect scripts
+  size_t pos   = name.find_first_of(_("/\\"), start);
+  if (start >= pos || pos == String::npos) return PackagedP();
+  // open package
+  PackagedP p = openAny(name.substr(start, pos-start));
+  if (package && !is_substr(name,start,_(":NO-WARN-DEP:"))) {
+    package->requireDependency(p.get());
+  }
+  name_out = name.substr(pos + 1);
+  return p;
+}
+
 pair<unique_ptr<wxInputStream>,Packaged*> PackageManager::openFileFromPackage(Packaged* package, const String& name) {
-  if (!name.empty() && name.GetChar(0) == _('/')) {
-    // absolute name; break name
-    size_t start = name.find_first_not_of(_("/\\"), 1); // allow "//package/name" from incorrect scripts
-    size_t pos   = name.find_first_of(_("/\\"), start);
-    if (start < pos && pos != String::npos) {
-      // open package
-      PackagedP p = openAny(name.substr(start, pos-start));
-      if (package && !is_substr(name,start,_(":NO-WARN-DEP:"))) {
-        package->requireDependency(p.get());
-      }
-      return {p->openIn(name.substr(pos + 1)), p.get()};
-    }
-  } else if (package) {
+  String file;
+  if (PackagedP p = openPackageOf(package, name, file)) {
+    return {p->openIn(file), p.get()};
+  } else if (package && !starts_with(name, _("/"))) {
     // relative name
     return {package->openIn(name), package};
   }
@@ -133,19 +139,10 @@ pair<unique_ptr<wxInputStream>, Packaged*> openFileFromPackage(Packaged* package
 }
 
 String PackageManager::openFilenameFromPackage(Packaged* package, const String& name) {
-  if (!name.empty() && name.GetChar(0) == _('/')) {
-    // absolute name; break name
-    size_t start = name.find_first_not_of(_("/\\"), 1); // allow "//package/name" from incorrect scripts
-    size_t pos   = name.find_first_of(_("/\\"), start);
-    if (start < pos && pos != String::npos) {
-      // open package
-      PackagedP p = openAny(name.substr(start, pos-start));
-      if (package && !is_substr(name,start,_(":NO-WARN-DEP:"))) {
-        package->requireDependency(p.get());
-      }
-      return p->absoluteFilename() + _("/") + name.substr(pos + 1);
-    }
-  } else if (package) {
+  String file;
+  if (PackagedP p = openPackageOf(package, name, file)) {
+    return p->absoluteFilename() + _("/") + file;
+  } else if (package && !starts_with(name, _("/"))) {
     // relative name
     return package->absoluteFilename() + _("/") + name;
   }
@@ -143,6 +143,13 @@ public:
   /// Check if a file exists in a package
   bool existsInPackage(const String& name);
 
+  /// Open the package that a name encoded as "/package/file" refers to
+  /** Returns the package, and sets name_out to the name of the file inside it.
+   *  Returns nullptr if the name is not of that form, i.e. if it is relative.
+   *  If 'package' is set then a dependency from that package is verified.
+   */
+  PackagedP openPackageOf(Packaged* package, const String& name, String& name_out);
+
   /// Open a file from a package, with a name encoded as "/package/file"
   /** If 'package' is set then:
    *    - tries to open a relative file from the package if the name is "file"
@@ -13,7 +13,12 @@
 // ----------------------------------------------------------------------------- : OrderCache
 
 /// Object that cashes an ordered version of a list of items, for finding the position of objects
-/** Can be used as a map "void* -> int" for finding the position of an object */
+/** Can be used as a map "void* -> int" for finding the position of an object.
+ *
+ *  When the value of a single item changes, that item is moved to its new position,
+ *  the other items don't have to be ordered again.
+ *  Items with the same value keep the order of the original list.
+ */
 template <typename T>
 class OrderCache : public IntrusivePtrBase<OrderCache<T>> {
 public:
@@ -22,33 +27,41 @@ public:
    *  @pre keys.size() == values.size()
    */
   OrderCache(const vector<T>& keys, const vector<String>& values, vector<int>* keep = nullptr);
-  
+
   /// Find the position of the given key in the cache, returns -1 if not found
   int find(const T& key) const;
-  
+  /// The number of items that are kept
+  inline int size() const { return (int)sorted.size(); }
+
+  /// Mark the value of a key as changed
+  void invalidate(const T& key);
+  /// The keys that were invalidated since the last call, their values should be passed to update
+  vector<T> takeInvalidated();
+  /// Change the value of a key, and whether it is kept, and move it to its new position
+  void update(const T& key, const String& value, bool keep);
+
 private:
-  struct CompareKeys;
-  struct CompareValues;
-  typedef pair<void*,int> KV;
-  vector<KV> positions;
+  struct Item {
+    String value;
+    int    tie;          ///< Position in the original list, to order items with the same value
+    bool   keep;
+    bool   invalidated;
+  };
+  struct CompareItems;
+  unordered_map<const void*,Item> items; ///< Note: pointers to the items stay valid
+  vector<const Item*> sorted;            ///< The items that are kept, in order
+  vector<T> invalidated;
+
+  typename vector<const Item*>::iterator position(const Item& item);
 };
 
 // ----------------------------------------------------------------------------- : Implementation
 
 template <typename T>
-struct OrderCache<T>::CompareKeys {
-  inline bool operator () (const KV& a, void*     b) { return a.first < b; }
-  inline bool operator () (const KV& a, const KV& b) { return a.first < b.first; }
-  inline bool operator () (void*     a, const KV& b) { return a       < b.first; }
-};
-
-template <typename T>
-struct OrderCache<T>::CompareValues {
-  const vector<String>& values;
-  CompareValues(const vector<String>& values) : values(values) {}
-  
-  inline bool operator () (const KV& a, const KV& b) {
-    return smart_less(values[a.second], values[b.second]);
+struct OrderCache<T>::CompareItems {
+  inline bool operator () (const Item* a, const Item* b) const {
+    int c = smart_compare(a->value, b->value);
+    return c < 0 || (c == 0 && a->tie < b->tie);
   }
 };
 
@@ -56,29 +69,54 @@ template <typename T>
 OrderCache<T>::OrderCache(const vector<T>& keys, const vector<String>& values, vector<int>* keep) {
   assert(keys.size() == values.size());
   assert(!keep || keep->size() == keys.size());
-  // initialize positions, use pos to point back to the values vector
-  positions.reserve(keys.size());
-  int i = 0;
-  for (typename vector<T>::const_iterator it = keys.begin() ; it != keys.end() ; ++it, ++i) {
-    if (!keep || (*keep)[i]) {
-      positions.push_back(KV(&**it, i));
-    }
-  }
-  // sort the KVs by the values
-  sort(positions.begin(), positions.end(), CompareValues(values));
-  // update positions, to point to sorted list
-  i = 0;
-  for (typename vector<KV>::iterator it = positions.begin() ; it != positions.end() ; ++it, ++i) {
-    it->second = i;
+  items.reserve(keys.size());
+  sorted.reserve(keys.size());
+  for (size_t i = 0 ; i < keys.size() ; ++i) {
+    bool kept = !keep || (*keep)[i];
+    Item& item = items[&*keys[i]];
+    item = Item{values[i], (int)i, kept, false};
+    if (kept) sorted.push_back(&item);
   }
-  // sort the KVs by the keys
-  sort(positions.begin(), positions.end(), CompareKeys());
+  sort(sorted.begin(), sorted.end(), CompareItems());
+}
+
+template <typename T>
+typename vector<const typename OrderCache<T>::Item*>::iterator OrderCache<T>::position(const Item& item) {
+  return lower_bound(sorted.begin(), sorted.end(), &item, CompareItems());
 }
 
 template <typename T>
 int OrderCache<T>::find(const T& key) const {
-  vector<KV>::const_iterator it = lower_bound(positions.begin(), positions.end(), &*key, CompareKeys());
-  if (it == positions.end() || it->first != &*key) return -1;
-  return it->second;
+  auto it = items.find(&*key);
+  if (it == items.end() || !it->second.keep) return -1;
+  return (int)(lower_bound(sorted.begin(), sorted.end(), &it->second, CompareItems()) - sorted.begin());
+}
+
+template <typename T>
+void OrderCache<T>::invalidate(const T& key) {
+  auto it = items.find(&*key);
+  if (it == items.end() || it->second.invalidated) return;
+  it->second.invalidated = true;
+  invalidated.push_back(key);
+}
+
+template <typename T>
+vector<T> OrderCache<T>::takeInvalidated() {
+  vector<T> keys;
+  swap(keys, invalidated);
+  for (auto const& key : keys) {
+    items.at(&*key).invalidated = false;
+  }
+  return keys;
 }
 
+template <typename T>
+void OrderCache<T>::update(const T& key, const String& value, bool keep) {
+  auto it = items.find(&*key);
+  if (it == items.end()) return;
+  Item& item = it->second;
+  if (item.keep) sorted.erase(position(item));
+  item.value = value;
+  item.keep  = keep;
+  if (item.keep) sorted.insert(position(item), &item);
+}
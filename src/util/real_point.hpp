@@ -182,6 +182,13 @@ public:
   inline wxRect toRect() const {
     return *this;
   }
+  
+  inline bool operator == (const RealRect& that) const {
+    return x == that.x && y == that.y && width == that.width && height == that.height;
+  }
+  inline bool operator != (const RealRect& that) const {
+    return !(*this == that);
+  }
 };
 
 /// Split a rectangle horizontally
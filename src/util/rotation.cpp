@@ -168,6 +168,71 @@ Rotater::~Rotater() {
   rot = old; // restore
 }
 
+// ----------------------------------------------------------------------------- : TextExtentCache
+
+TextExtentCache text_extent_cache;
+
+// Maximum memory to use for text extents
+static const size_t text_extent_budget = 8 * 1024 * 1024;
+
+// Estimated memory used by an entry: the key (twice, in the list and the index),
+// the widths and some overhead for the nodes
+static size_t text_extent_memory_size(const String& key, const TextExtentCache::Extent& extent) {
+  return 2 * key.size() * sizeof(Char) + extent.partial.size() * sizeof(int) + 128;
+}
+
+TextExtentCache::TextExtentCache()
+  : bytes(0)
+  , hits(0), misses(0), evictions(0)
+{}
+
+bool TextExtentCache::find(const String& key, Extent& out) {
+  wxMutexLocker lock(mutex);
+  auto it = index.find(key);
+  if (it == index.end()) {
+    ++misses;
+    return false;
+  }
+  ++hits;
+  entries.splice(entries.begin(), entries, it->second); // most recently used
+  out = it->second->extent;
+  return true;
+}
+
+void TextExtentCache::add(const String& key, const Extent& extent) {
+  wxMutexLocker lock(mutex);
+  size_t size = text_extent_memory_size(key, extent);
+  auto it = index.find(key);
+  if (it != index.end()) {
+    // another thread measured the same text
+    bytes -= it->second->bytes;
+    entries.erase(it->second);
+    index.erase(it);
+  }
+  entries.push_front(Entry{key, extent, size});
+  index[key] = entries.begin();
+  bytes += size;
+  // evict least recently used entries
+  while (bytes > text_extent_budget && !entries.empty()) {
+    bytes -= entries.back().bytes;
+    index.erase(entries.back().key);
+    entries.pop_back();
+    ++evictions;
+  }
+}
+
+void TextExtentCache::clear() {
+  wxMutexLocker lock(mutex);
+  entries.clear();
+  index.clear();
+  bytes = 0;
+}
+
+TextExtentCache::Stats TextExtentCache::stats() {
+  wxMutexLocker lock(mutex);
+  return Stats{index.size(), bytes, text_extent_budget, hits, misses, evictions};
+}
+
 // ----------------------------------------------------------------------------- : RotatedDC
 
 RotatedDC::RotatedDC(DC& dc, Radians angle, const RealRect& rect, double zoom, RenderQuality quality, RotationFlags flags)
@@ -310,6 +375,7 @@ void RotatedDC::SetTextForeground(const Color& color) { dc.SetTextForeground(col
 void RotatedDC::SetLogicalFunction(wxRasterOperationMode function)      { dc.SetLogicalFunction(function); }
 
 void RotatedDC::SetFont(const wxFont& font) {
+  font_key.clear();
   if (quality == QUALITY_LOW && zoomX == 1 && zoomY == 1) {
     dc.SetFont(font);
   } else {
@@ -323,7 +389,11 @@ void RotatedDC::SetFont(const wxFont& font) {
   }
 }
 void RotatedDC::SetFont(const Font& font, double scale) {
-  dc.SetFont(font.toWxFont(trS(scale) * (quality == QUALITY_LOW ? 1 : text_scaling)));
+  String key;
+  dc.SetFont(font.toWxFont(trS(scale) * (quality == QUALITY_LOW ? 1 : text_scaling), key));
+  // different kinds of dcs can measure text differently
+  font_key = dc.GetClassInfo()->GetClassName();
+  font_key << _('\1') << key;
 }
 
 double RotatedDC::getFontSizeStep() const {
@@ -334,30 +404,65 @@ double RotatedDC::getFontSizeStep() const {
   }
 }
 
-RealSize RotatedDC::GetTextExtent(const String& text) const {
-  int w, h;
-  dc.GetTextExtent(text, &w, &h);
+void RotatedDC::getDeviceTextExtent(const String& text, TextExtentCache::Extent& e, bool partial) const {
+  String key;
+  if (!font_key.empty()) {
+    key << font_key << (partial ? _("\1p\1") : _("\1\1")) << text;
+    if (text_extent_cache.find(key, e)) return;
+  }
+  dc.GetTextExtent(text, &e.width, &e.height);
   #ifdef __WXGTK__
     // HACK: Some fonts don't get the descender height set correctly.
     int charHeight = dc.GetCharHeight();
-    if (charHeight != h)
-      h += h - charHeight;
+    if (charHeight != e.height)
+      e.height += e.height - charHeight;
   #endif
+  e.partial.clear();
+  if (partial) {
+    wxArrayInt extents;
+    dc.GetPartialTextExtents(text, extents);
+    e.partial.assign(extents.begin(), extents.end());
+  }
+  if (!key.empty()) text_extent_cache.add(key, e);
+}
+
+RealSize RotatedDC::GetTextExtent(const String& text) const {
+  TextExtentCache::Extent e;
+  getDeviceTextExtent(text, e, false);
   if (quality == QUALITY_LOW) {
-    return RealSize(w / zoomX, h / zoomY);
+    return RealSize(e.width / zoomX, e.height / zoomY);
   } else {
-    return RealSize(w / (zoomX * text_scaling), h / (zoomY * text_scaling));
+    return RealSize(e.width / (zoomX * text_scaling), e.height / (zoomY * text_scaling));
+  }
+}
+RealSize RotatedDC::GetPartialTextExtents(const String& text, vector<double>& widths) const {
+  TextExtentCache::Extent e;
+  getDeviceTextExtent(text, e, true);
+  double scale_x = quality == QUALITY_LOW ? zoomX : zoomX * text_scaling;
+  double scale_y = quality == QUALITY_LOW ? zoomY : zoomY * text_scaling;
+  widths.resize(e.partial.size());
+  for (size_t i = 0 ; i < e.partial.size() ; ++i) {
+    widths[i] = e.partial[i] / scale_x;
   }
+  return RealSize(e.width / scale_x, e.height / scale_y);
 }
 double RotatedDC::GetCharHeight() const {
-  int h = dc.GetCharHeight();
-  #ifdef __WXGTK__
-    // See above HACK
-    int extent;
-    dc.GetTextExtent(_("H"), 0, &extent);
-    if (h != extent)
-      h = 2 * extent - h;
-  #endif
+  TextExtentCache::Extent e;
+  if (!font_key.empty() && text_extent_cache.find(font_key, e)) {
+    // the height of the font is stored under just the key of the font
+  } else {
+    e.height = dc.GetCharHeight();
+    #ifdef __WXGTK__
+      // See above HACK
+      int extent;
+      dc.GetTextExtent(_("H"), 0, &extent);
+      if (e.height != extent)
+        e.height = 2 * extent - e.height;
+    #endif
+    e.width = 0;
+    if (!font_key.empty()) text_extent_cache.add(font_key, e);
+  }
+  int h = e.height;
   if (quality == QUALITY_LOW) {
     return h / zoomY;
   } else {
@@ -11,6 +11,8 @@
 #include <util/prec.hpp>
 #include <util/real_point.hpp>
 #include <gfx/gfx.hpp>
+#include <wx/thread.h>
+#include <list>
 
 class Font;
 
@@ -132,6 +134,60 @@ private:
   Rotation& rot;
 };
 
+// ----------------------------------------------------------------------------- : TextExtentCache
+
+/// Cache of measured text
+/** Text layout measures the same text in the same fonts over and over again:
+ *  for every scale that is tried, and every time a card is shown.
+ *  Extents are stored in device units, keyed by the kind of dc, the font (see Font::toWxFont) and the text.
+ *
+ *  Keys are whole lines of text, and extents can hold the width of every prefix,
+ *  so the size of the cache is bounded by an estimate of its memory use.
+ *  When it is exceeded, the least recently used extents are evicted.
+ */
+class TextExtentCache {
+public:
+  TextExtentCache();
+  
+  /// Extent of a piece of text in device units
+  struct Extent {
+    int width, height;
+    vector<int> partial; ///< Widths of all prefixes, if requested
+  };
+  
+  bool find(const String& key, Extent& out);
+  void add(const String& key, const Extent& extent);
+  void clear();
+  
+  /// Statistics about the use of the cache
+  struct Stats {
+    size_t entries;    ///< Number of extents in the cache
+    size_t bytes;      ///< Estimated memory used by those extents
+    size_t budget;     ///< Maximum memory to use
+    size_t hits;       ///< Number of lookups that found the extent
+    size_t misses;     ///< Number of lookups that had to measure the text
+    size_t evictions;  ///< Number of extents evicted because of the budget
+  };
+  Stats stats();
+  
+private:
+  struct Entry {
+    String key;
+    Extent extent;
+    size_t bytes;
+  };
+  typedef list<Entry> Entries;
+  
+  wxMutex mutex;
+  Entries entries;  ///< Most recently used entries first
+  unordered_map<String,Entries::iterator> index;
+  size_t bytes;
+  size_t hits, misses, evictions;
+};
+
+/// The global text extent cache
+extern TextExtentCache text_extent_cache;
+
 // ----------------------------------------------------------------------------- : RotatedDC
 
 /// Render quality of text
@@ -199,6 +255,9 @@ public:
   double getFontSizeStep() const;
   
   RealSize GetTextExtent(const String& text) const;
+  /// Get the extent of a string, and the widths of all its prefixes, measured in one go
+  /** widths[i] is the width of text.substr(0,i+1) */
+  RealSize GetPartialTextExtents(const String& text, vector<double>& widths) const;
   double GetCharHeight() const;
   
   void SetClippingRegion(const RealRect& rect);
@@ -214,5 +273,9 @@ public:
 private:
   wxDC& dc;        ///< The actual dc
   RenderQuality quality;  ///< Quality of the text
+  String font_key; ///< Key of the current font in the text_extent_cache, or empty if it is not cached
+  
+  /// Measure text in device units, or find it in the cache
+  void getDeviceTextExtent(const String& text, TextExtentCache::Extent& out, bool partial) const;
 };
 
@@ -62,7 +62,10 @@ SpellChecker::SpellChecker(const char* aff_path, const char* dic_path)
   , encoding(String(get_dic_encoding(), IF_UNICODE(wxConvLibc, wxSTRING_MAXLEN)))
 {}
 
+void stop_checking_in_background();
+
 void SpellChecker::destroyAll() {
+  stop_checking_in_background();
   spellers.clear();
 }
 
@@ -102,14 +105,35 @@ bool SpellChecker::convert_encoding(const String& word, CharBuffer& out) {
   }
 }
 
+// Don't let the cache grow without bounds
+const size_t MAX_CACHED_WORDS = 100000;
+
 bool SpellChecker::spell(const String& word) {
   if (word.empty()) return true; // empty word is okay
+  wxMutexLocker lock(mutex);
+  auto it = words.find(word);
+  if (it != words.end()) return it->second;
   CharBuffer str;
-  if (!convert_encoding(word,str)) return false;
-  return Hunspell::spell(str);
+  bool correct = convert_encoding(word,str) && Hunspell::spell(str);
+  if (words.size() >= MAX_CACHED_WORDS) words.clear();
+  words.emplace(word, correct);
+  return correct;
+}
+
+bool SpellChecker::spellCached(const String& word, bool& correct) {
+  if (word.empty()) {
+    correct = true;
+    return true;
+  }
+  wxMutexLocker lock(mutex);
+  auto it = words.find(word);
+  if (it == words.end()) return false;
+  correct = it->second;
+  return true;
 }
 
 void SpellChecker::suggest(const String& word, vector<String>& suggestions_out) {
+  wxMutexLocker lock(mutex);
   CharBuffer str;
   if (!convert_encoding(word,str)) return;
   // call Hunspell
@@ -122,3 +146,75 @@ void SpellChecker::suggest(const String& word, vector<String>& suggestions_out)
   }
   free(suggestions);
 }
+
+// ----------------------------------------------------------------------------- : Spell checker : background
+
+bool SpellChecker::use_background_thread = false;
+
+/// Thread that checks the words queued with checkInBackground
+class SpellCheckWorker : public wxThread {
+public:
+  ExitCode Entry() override;
+  
+  static wxMutex mutex; ///< Protects the members below
+  static deque<pair<SpellChecker*,String>> queue; ///< Words to check
+  static SpellCheckWorker* worker; ///< The worker thread, invariant: no words ==> worker==nullptr
+};
+
+wxMutex SpellCheckWorker::mutex;
+deque<pair<SpellChecker*,String>> SpellCheckWorker::queue;
+SpellCheckWorker* SpellCheckWorker::worker = nullptr;
+
+wxThread::ExitCode SpellCheckWorker::Entry() {
+  while (true) {
+    pair<SpellChecker*,String> next;
+    {
+      wxMutexLocker lock(mutex);
+      if (queue.empty()) {
+        worker = nullptr;
+        break; // No more words
+      }
+      next = queue.front();
+      queue.pop_front();
+    }
+    next.first->spell(next.second);
+    {
+      wxMutexLocker lock(next.first->mutex);
+      next.first->queued.erase(next.second);
+    }
+  }
+  // let the main thread update the values that were waiting for us
+  wxWakeUpIdle();
+  return 0;
+}
+
+void SpellChecker::checkInBackground(const String& word) {
+  {
+    wxMutexLocker lock(mutex);
+    if (words.find(word) != words.end()) return;    // already known
+    if (!queued.insert(word).second) return;        // already queued
+  }
+  wxMutexLocker lock(SpellCheckWorker::mutex);
+  SpellCheckWorker::queue.emplace_back(this, word);
+  if (!SpellCheckWorker::worker) {
+    SpellCheckWorker::worker = new SpellCheckWorker();
+    SpellCheckWorker::worker->Create();
+    SpellCheckWorker::worker->Run();
+  }
+}
+
+bool SpellChecker::checkingInBackground() {
+  wxMutexLocker lock(SpellCheckWorker::mutex);
+  return SpellCheckWorker::worker != nullptr;
+}
+
+void stop_checking_in_background() {
+  {
+    wxMutexLocker lock(SpellCheckWorker::mutex);
+    SpellCheckWorker::queue.clear();
+  }
+  // wait for the word that is being checked
+  while (SpellChecker::checkingInBackground()) {
+    wxMilliSleep(1);
+  }
+}
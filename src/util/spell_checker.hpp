@@ -9,6 +9,8 @@
 // ----------------------------------------------------------------------------- : Includes
 
 #include <util/prec.hpp>
+#include <wx/thread.h>
+#include <unordered_set>
 #undef near
 #include "hunspell.hxx"
 
@@ -35,19 +37,37 @@ public:
    *  Note: This is not threadsafe yet */
   static SpellChecker* get(const String& filename, const String& language);
   /// Destroy all cached SpellChecker objects
+  /** Stops checking words in the background */
   static void destroyAll();
 
   /// Check the spelling of a single word
+  /** The results are cached, and this function can be used from any thread */
   bool spell(const String& word);
+  /// Check the spelling of a single word, if the result is already known.
+  /** Returns false if the result is not known, does not call Hunspell. */
+  bool spellCached(const String& word, bool& correct);
 
   /// Give spelling suggestions
   void suggest(const String& word, vector<String>& suggestions_out);
 
+  /// Check the spelling of a word in a background thread, after that the result is cached.
+  void checkInBackground(const String& word);
+  /// Are there still words to be checked in the background?
+  static bool checkingInBackground();
+  /// Should words that are not in the cache be checked in the background by check_spelling?
+  /** Only useful when there is a main loop to update the values afterwards, so only set in the GUI */
+  static bool use_background_thread;
+
 private:
   /// Convert between String and dictionary encoding
   wxCSConv encoding;
   bool convert_encoding(const String& word, CharBuffer& out);
 
+  wxMutex mutex;                      ///< Hunspell is not thread safe, also protects the members below
+  unordered_map<String,bool> words;   ///< Words checked before, and whether they were correct
+  unordered_set<String>      queued;  ///< Words waiting to be checked in the background
+
   static map<String,SpellCheckerP> spellers; //< Cached checkers for each language
+  friend class SpellCheckWorker;
 };
 
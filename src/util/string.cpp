@@ -15,7 +15,20 @@
 
 void writeUTF8(wxTextOutputStream& stream, const String& str) {
   #ifdef UNICODE
-    stream.WriteString(str);
+    // Write long strings in parts, converting all at once would need another copy of the string in memory
+    const size_t CHUNK_SIZE = 1 << 16;
+    if (str.size() <= CHUNK_SIZE) {
+      stream.WriteString(str);
+      return;
+    }
+    for (size_t pos = 0 ; pos < str.size() ; ) {
+      size_t len = min(CHUNK_SIZE, str.size() - pos);
+      // don't split surrogate pairs
+      wxUniChar last = str[pos + len - 1];
+      if (pos + len < str.size() && last >= 0xD800 && last <= 0xDBFF) ++len;
+      stream.WriteString(str.substr(pos, len));
+      pos += len;
+    }
   #else
     wxWCharBuffer buf = str.wc_str(*wxConvCurrent);
     stream.WriteString(wxString(buf, wxConvUTF8));
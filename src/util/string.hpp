@@ -67,6 +67,7 @@ typedef wxChar Char;
 const wchar_t BYTE_ORDER_MARK[] = L"\xFEFF";
 
 /// Writes a string to an output stream, encoded as UTF8
+/** Long strings are written in parts */
 void writeUTF8(wxTextOutputStream& stream, const String& str);
 
 /// Remove a UTF-8 Byte order mark from an input stream
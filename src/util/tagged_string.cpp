@@ -325,6 +325,62 @@ String anti_tag(const String& tag) {
 
 // ----------------------------------------------------------------------------- : Cursor position
 
+// The cursor position for an index inside the atom starting at i, with the close tag at close.
+// cursor is the cursor position before the atom.
+size_t index_to_cursor_in_atom(const String& str, size_t i, size_t close, size_t index, size_t cursor, Movement dir) {
+  // Index is inside an atom, determine on which side we want the cursor
+  // This is the only place where MOVE_LEFT/RIGHT and MOVE_*_OPT differ
+  // for the OPT version we must check if we are actually past any real characters
+  // but, if the atom is empty, it still counts as a single character!
+  if (dir == MOVE_LEFT) {
+    return cursor;
+  } else if (dir == MOVE_RIGHT) {
+    return cursor + 1;
+  } else if (dir == MOVE_LEFT_OPT) {
+    // is there any non-tag after index?
+    bool empty = true;
+    while (i < close) {
+      Char c = str.GetChar(i);
+      if (c == _('<')) {
+        i = skip_tag(str, i);
+      } else if (i >= index) {
+        return cursor; // this is a non-tag character after index
+      } else {
+        empty = false;
+        ++i;
+      }
+    }
+    return empty ? cursor : cursor + 1; // still didn't pass any
+  } else if (dir == MOVE_RIGHT_OPT) {
+    // is index actually past any non-tag?
+    while (i < close) {
+      if (i >= index) {
+        return cursor; // we didn't pass any non-tag stuff
+      }
+      Char c = str.GetChar(i);
+      if (c != _('<')) break;
+      i = skip_tag(str, i);
+    }
+    return cursor + 1; // yes it is
+  } else {
+    // count number of actual characters before/after
+    int before_c = 0;
+    int after_c  = 0;
+    while (i < close) {
+      Char c = str.GetChar(i);
+      if (c == _('<')) {
+        i = skip_tag(str, i);
+      } else {
+        if (i < index) before_c++;
+        else           after_c++;
+        ++i;
+      }
+    }
+    // take the closest side
+    return before_c <= after_c ? cursor : cursor + 1;
+  }
+}
+
 size_t index_to_cursor(const String& str, size_t index, Movement dir) {
   size_t cursor = 0;
   index = min(index, str.size());
@@ -341,57 +397,7 @@ size_t index_to_cursor(const String& str, size_t index, Movement dir) {
         size_t close = match_close_tag(str, i);
         size_t after = skip_tag(str, close);
         if (index > before && index < after) {
-          // Index is inside an atom, determine on which side we want the cursor
-          // This is the only place where MOVE_LEFT/RIGHT and MOVE_*_OPT differ
-          // for the OPT version we must check if we are actually past any real characters
-          // but, if the atom is empty, it still counts as a single character!
-          if (dir == MOVE_LEFT) {
-            return cursor;
-          } else if (dir == MOVE_RIGHT) {
-            return cursor + 1;
-          } else if (dir == MOVE_LEFT_OPT) {
-            // is there any non-tag after index?
-            bool empty = true;
-            while (i < close) {
-              c = str.GetChar(i);
-              if (c == _('<')) {
-                i = skip_tag(str, i);
-              } else if (i >= index) {
-                return cursor; // this is a non-tag character after index
-              } else {
-                empty = false;
-                ++i;
-              }
-            }
-            return empty ? cursor : cursor + 1; // still didn't pass any
-          } else if (dir == MOVE_RIGHT_OPT) {
-            // is index actually past any non-tag?
-            while (i < close) {
-              if (i >= index) {
-                return cursor; // we didn't pass any non-tag stuff
-              }
-              c = str.GetChar(i);
-              if (c != _('<')) break;
-              i = skip_tag(str, i);
-            }
-            return cursor + 1; // yes it is
-          } else if (dir == MOVE_MID) {
-            // count number of actual characters before/after
-            int before_c = 0;
-            int after_c  = 0;
-            while (i < close) {
-              c = str.GetChar(i);
-              if (c == _('<')) {
-                i = skip_tag(str, i);
-              } else {
-                if (i < index) before_c++;
-                else           after_c++;
-                ++i;
-              }
-            }
-            // take the closest side
-            return before_c <= after_c ? cursor : cursor + 1;
-          }
+          return index_to_cursor_in_atom(str, i, close, index, cursor, dir);
         }
         i = after;
       } else if (i == 0 && is_substr(str, i, _("<prefix"))) {
@@ -459,9 +465,8 @@ void cursor_to_index_range(const String& str, size_t cursor, size_t& start, size
   end = max(end, start + 1); // always start < end, since there are always valid cursor positions
 }
 
-size_t cursor_to_index(const String& str, size_t cursor, Movement dir) {
-  size_t start, end;
-  cursor_to_index_range(str, cursor, start, end);
+// Pick the index in the range [start...end) for a cursor position
+size_t cursor_range_to_index(const String& str, size_t start, size_t end, Movement dir) {
   assert(end <= str.size()+1);
   if (dir == MOVE_MID) {
     // find the middle between start and end
@@ -490,6 +495,12 @@ size_t cursor_to_index(const String& str, size_t cursor, Movement dir) {
   return dir <= 0 /*MOVE_LEFT*/ ? start : end - 1;
 }
 
+size_t cursor_to_index(const String& str, size_t cursor, Movement dir) {
+  size_t start, end;
+  cursor_to_index_range(str, cursor, start, end);
+  return cursor_range_to_index(str, start, end, dir);
+}
+
 String untag_for_cursor(const String& str) {
   String ret; ret.reserve(str.size());
   for (size_t i = 0 ; i < str.size() ; ) {
@@ -555,6 +566,177 @@ size_t index_to_untagged(const String& str, size_t index) {
   return p;
 }
 
+// ----------------------------------------------------------------------------- : TaggedText
+
+TaggedText::TaggedText()
+  : prefix_end(0), suffix(0), cursors(0)
+{}
+
+TaggedText::TaggedText(const String& str)
+  : TaggedText()
+{
+  assign(str);
+}
+
+void TaggedText::assign(const String& str) {
+  text = str;
+  untagged_text = untag(str);
+  tags.clear();
+  segments.clear();
+  runs.clear();
+  size_t size = text.size();
+  // tags and the text between them
+  size_t untagged = 0;
+  for (size_t i = 0 ; i < size ; ) {
+    if (text.GetChar(i) == _('<')) {
+      size_t end = min(skip_tag(text, i), size);
+      tags.push_back(Tag{i, end, untagged});
+      i = end;
+    } else {
+      size_t begin = i;
+      while (i < size && text.GetChar(i) != _('<')) ++i;
+      segments.push_back(Segment{begin, i, untagged});
+      untagged += i - begin;
+    }
+  }
+  // runs of cursor positions, see index_to_cursor
+  prefix_end = 0;
+  suffix = size;
+  cursors = 0;
+  for (size_t i = 0 ; i < size ; ) {
+    if (text.GetChar(i) == _('<')) {
+      if (is_substr(text, i, _("<atom")) || is_substr(text, i, _("<sep"))) {
+        // atom counts as a single 'character'
+        size_t close = match_close_tag(text, i);
+        size_t after = skip_tag(text, close);
+        if (after == String::npos) break;
+        runs.push_back(Run{i, after, cursors++, close});
+        i = after;
+      } else if (i == 0 && is_substr(text, i, _("<prefix"))) {
+        i = prefix_end = match_close_tag_end(text, i);
+      } else if (is_substr(text, i, _("<suffix")) && match_close_tag_end(text, i) >= size) {
+        suffix = i;
+        break;
+      } else {
+        i = skip_tag(text, i);
+      }
+    } else {
+      if (!runs.empty() && runs.back().close == String::npos && runs.back().end == i) {
+        runs.back().end++;
+      } else {
+        runs.push_back(Run{i, i + 1, cursors, String::npos});
+      }
+      ++cursors;
+      ++i;
+    }
+  }
+}
+
+const TaggedText::Run& TaggedText::runAtCursor(size_t cursor) const {
+  auto it = upper_bound(runs.begin(), runs.end(), cursor, [](size_t c, const Run& r) { return c < r.cursor; });
+  assert(it != runs.begin());
+  return *--it;
+}
+
+size_t TaggedText::indexToCursor(size_t index, Movement dir) const {
+  index = min(index, text.size());
+  // the last run that starts before index
+  auto it = upper_bound(runs.begin(), runs.end(), index, [](size_t i, const Run& r) { return i <= r.begin; });
+  if (it == runs.begin()) return 0;
+  const Run& run = *--it;
+  if (run.close != String::npos) {
+    if (index < run.end) {
+      return index_to_cursor_in_atom(text, run.begin, run.close, index, run.cursor, dir);
+    }
+    return run.cursor + 1;
+  } else {
+    return run.cursor + min(index, run.end) - run.begin;
+  }
+}
+
+void TaggedText::cursorToIndexRange(size_t cursor, size_t& start, size_t& end) const {
+  if (cursor > cursors) {
+    start = end = suffix;
+  } else {
+    // start after the previous cursor position
+    if (cursor == 0) {
+      start = prefix_end;
+    } else {
+      const Run& run = runAtCursor(cursor - 1);
+      start = run.close == String::npos ? run.begin + cursor - run.cursor : run.end;
+    }
+    // end at the next one, but never move the end over an atom/sep
+    if (cursor < cursors) {
+      const Run& run = runAtCursor(cursor);
+      end = run.close == String::npos ? run.begin + cursor - run.cursor + 1 : run.begin + 1;
+    } else {
+      end = suffix;
+    }
+  }
+  end = max(end, start + 1);
+}
+
+size_t TaggedText::cursorToIndex(size_t cursor, Movement dir) const {
+  size_t start, end;
+  cursorToIndexRange(cursor, start, end);
+  return cursor_range_to_index(text, start, end, dir);
+}
+
+size_t TaggedText::untaggedToIndex(size_t pos, bool inside) const {
+  // tags between the characters before and at pos
+  auto it = lower_bound(tags.begin(), tags.end(), pos, [](const Tag& t, size_t p) { return t.untagged < p; });
+  for ( ; it != tags.end() && it->untagged == pos ; ++it) {
+    bool is_close = is_substr(text, it->begin, _("</"));
+    if (is_close == inside) return it->begin;
+  }
+  // the character at pos
+  auto seg = upper_bound(segments.begin(), segments.end(), pos, [](size_t p, const Segment& s) { return p < s.untagged; });
+  if (seg == segments.begin()) return text.size();
+  --seg;
+  if (pos - seg->untagged < seg->end - seg->begin) {
+    return seg->begin + pos - seg->untagged;
+  }
+  return text.size();
+}
+
+size_t TaggedText::indexToUntagged(size_t index) const {
+  index = min(index, text.size());
+  // the last segment that starts before index
+  auto seg = upper_bound(segments.begin(), segments.end(), index, [](size_t i, const Segment& s) { return i <= s.begin; });
+  if (seg == segments.begin()) return 0;
+  --seg;
+  return seg->untagged + min(index, seg->end) - seg->begin;
+}
+
+bool TaggedText::isInTag(const String& tag, size_t start, size_t end) const {
+  // Same as in_tag, but only looks at the tags
+  size_t size = text.size();
+  const Char* tag_name = static_cast<const Char*>(tag.c_str()) + 1;
+  end = min(end, size);
+  int taglevel = 0;
+  size_t pos = 0;
+  size_t last_start = String::npos;
+  FOR_EACH_CONST(t, tags) {
+    if (t.begin >= end) break;
+    // the text before this tag
+    if (pos < t.begin) {
+      if (t.begin >= start && taglevel < 1) return false;
+      pos = t.begin;
+    }
+    if (is_substr(text, pos + 1, tag_name) && pos+tag.size() < size && is_tag_end_char(text[pos+tag.size()])) {
+      if (pos < start) last_start = pos;
+      ++taglevel;
+    } else if (pos + 2 < size && text.GetChar(pos+1) == _('/') && is_substr(text, pos + 2, tag_name) && pos+1+tag.size() < size && is_tag_end_char(text[pos+1+tag.size()])) {
+      --taglevel; // close tag
+    }
+    pos = t.end;
+    if (pos >= start && taglevel < 1) return false;
+  }
+  // the text after the last tag
+  if (pos < end && end >= start && taglevel < 1) return false;
+  return taglevel >= 1 && last_start != String::npos;
+}
+
 // ----------------------------------------------------------------------------- : Global operations
 
 String remove_tag(const String& str, const String& tag) {
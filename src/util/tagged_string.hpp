@@ -178,6 +178,73 @@ size_t untagged_to_index(const String& str, size_t pos, bool inside, size_t star
  */
 size_t index_to_untagged(const String& str, size_t index);
 
+// ----------------------------------------------------------------------------- : TaggedText
+
+/// A tagged string together with an index of its tags, for answering many questions about the same string
+/** The functions above scan the string from the start on each call.
+ *  A TaggedText parses the string once, after that conversions between
+ *  indices, cursor positions and untagged positions are binary searches.
+ *
+ *  The results are the same as those of the corresponding functions on str().
+ */
+class TaggedText {
+public:
+  TaggedText();
+  explicit TaggedText(const String& str);
+  
+  /// Change the string, and parse it
+  void assign(const String& str);
+  
+  inline const String& str() const { return text; }
+  /// untag(str())
+  inline const String& untagged() const { return untagged_text; }
+  
+  /// index_to_cursor(str(), index, dir)
+  size_t indexToCursor(size_t index, Movement dir = MOVE_MID) const;
+  /// cursor_to_index_range(str(), cursor, begin, end)
+  void cursorToIndexRange(size_t cursor, size_t& begin, size_t& end) const;
+  /// cursor_to_index(str(), cursor, dir)
+  size_t cursorToIndex(size_t cursor, Movement dir = MOVE_MID) const;
+  /// Number of cursor positions after the first, index_to_cursor(str(), String::npos)
+  inline size_t cursorCount() const { return cursors; }
+  
+  /// untagged_to_index(str(), pos, inside)
+  size_t untaggedToIndex(size_t pos, bool inside) const;
+  /// index_to_untagged(str(), index)
+  size_t indexToUntagged(size_t index) const;
+  
+  /// is_in_tag(str(), tag, start, end)
+  bool isInTag(const String& tag, size_t start, size_t end) const;
+  
+private:
+  String text, untagged_text;
+  /// A tag in the text
+  struct Tag {
+    size_t begin, end; ///< Position of '<' and after '>'
+    size_t untagged;   ///< Number of non-tag characters before the tag
+  };
+  /// A piece of text between tags
+  struct Segment {
+    size_t begin, end;
+    size_t untagged;   ///< Number of non-tag characters before the segment
+  };
+  /// Characters or an atom that take up cursor positions
+  struct Run {
+    size_t begin, end;
+    size_t cursor;     ///< Cursor position before the run
+    size_t close;      ///< For atoms: position of the close tag, otherwise String::npos
+  };
+  vector<Tag>     tags;
+  vector<Segment> segments;
+  vector<Run>     runs;
+  size_t prefix_end; ///< Index after a <prefix> at the start of the string, or 0
+  size_t suffix;     ///< Index of a <suffix> at the end of the string, or the size of the string
+  size_t cursors;
+  
+  /// The run containing the given cursor position, which must be < cursors
+  const Run& runAtCursor(size_t cursor) const;
+};
+
 // ----------------------------------------------------------------------------- : Global operations
 
 /// Remove all instances of a tag and its close tag, but keep the contents.
@@ -16,5 +16,23 @@ add_test(
   COMMAND magicseteditor ${test_dir}/script/script-functions.mse-script
 )
 
+# Unit tests of internal data structures and algorithms
+# The test program is linked with all of MSE, except for the application class in main.cpp
+file(GLOB unit_test_sources "${test_dir}/unit/*.cpp")
+set(unit_test_mse_sources ${sources})
+list(FILTER unit_test_mse_sources EXCLUDE REGEX "/src/main\\.cpp$")
+add_executable(unit-tests ${unit_test_sources} ${unit_test_mse_sources})
+target_link_libraries(unit-tests $<TARGET_PROPERTY:magicseteditor,LINK_LIBRARIES>)
+target_precompile_headers(unit-tests REUSE_FROM magicseteditor)
+# one test per suite (file)
+file(GLOB unit_test_suites RELATIVE "${test_dir}/unit" "${test_dir}/unit/*_test.cpp")
+foreach(suite_file ${unit_test_suites})
+  string(REPLACE "_test.cpp" "" suite ${suite_file})
+  add_test(
+    NAME "unit-${suite}"
+    COMMAND unit-tests ${suite}
+  )
+endforeach()
+
 # Rendering tests
 # TODO
@@ -0,0 +1,101 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <data/keyword.hpp>
+#include "unit_test.hpp"
+#include <random>
+
+// ----------------------------------------------------------------------------- : Brute force
+
+// A keyword is a candidate if its literal text appears anywhere in the text, ignoring case
+static String lower(const String& s) {
+  String out;
+  for (wxUniChar c : s) out += (Char)toLower(c);
+  return out;
+}
+
+static set<const Keyword*> brute_force_candidates(const vector<pair<String,const Keyword*>>& literals, const String& text) {
+  set<const Keyword*> out;
+  String lower_text = lower(text);
+  FOR_EACH_CONST(l, literals) {
+    if (l.first.empty() || lower_text.find(lower(l.first)) != String::npos) {
+      out.insert(l.second);
+    }
+  }
+  return out;
+}
+
+static set<const Keyword*> matcher_candidates(const KeywordMatcher& matcher, const String& text) {
+  vector<const Keyword*> out;
+  matcher.candidates(text, out);
+  set<const Keyword*> out_set(out.begin(), out.end());
+  CHECK_MSG(out_set.size() == out.size(), _("duplicate candidates for '") + text + _("'"));
+  return out_set;
+}
+
+static String describe(const set<const Keyword*>& kws, const vector<Keyword>& keywords) {
+  String out;
+  FOR_EACH_CONST(kw, kws) out += String::Format(_(" %d"), (int)(kw - &keywords[0]));
+  return out;
+}
+
+// ----------------------------------------------------------------------------- : Tests
+
+TEST_CASE(keyword_matcher, fixed_literals) {
+  vector<Keyword> keywords(6);
+  vector<pair<String,const Keyword*>> literals = {
+    {_("flying"),       &keywords[0]},
+    {_("fly"),          &keywords[1]},
+    {_("ing"),          &keywords[2]},
+    {_("first strike"), &keywords[3]},
+    {_("strike"),       &keywords[4]},
+    {_(""),             &keywords[5]},
+  };
+  KeywordMatcher matcher;
+  FOR_EACH_CONST(l, literals) matcher.add(l.first, *l.second);
+  matcher.build();
+  const Char* texts[] = {
+    _(""), _("Flying"), _("FLY"), _("First Strike, flying"), _("double strike"), _("flinging"), _("fir strike"),
+  };
+  for (const Char* text : texts) {
+    set<const Keyword*> expected = brute_force_candidates(literals, text);
+    set<const Keyword*> actual   = matcher_candidates(matcher, text);
+    CHECK_MSG(expected == actual,
+              String(_("text '")) + text + _("': expected") + describe(expected, keywords) + _(", found") + describe(actual, keywords));
+  }
+}
+
+TEST_CASE(keyword_matcher, random_literals) {
+  // a small alphabet, so literals overlap a lot and many fail links are used
+  const Char alphabet[] = _("abAB c");
+  std::mt19937 rng(12345);
+  auto random_string = [&](size_t max_length) {
+    String s;
+    size_t length = rng() % (max_length + 1);
+    for (size_t i = 0 ; i < length ; ++i) s += alphabet[rng() % (sizeof(alphabet)/sizeof(Char) - 1)];
+    return s;
+  };
+  for (int round = 0 ; round < 200 ; ++round) {
+    vector<Keyword> keywords(1 + rng() % 20);
+    vector<pair<String,const Keyword*>> literals;
+    KeywordMatcher matcher;
+    FOR_EACH_CONST(kw, keywords) {
+      literals.emplace_back(random_string(5), &kw);
+      matcher.add(literals.back().first, kw);
+    }
+    matcher.build();
+    for (int t = 0 ; t < 20 ; ++t) {
+      String text = random_string(30);
+      set<const Keyword*> expected = brute_force_candidates(literals, text);
+      set<const Keyword*> actual   = matcher_candidates(matcher, text);
+      CHECK_MSG(expected == actual,
+                _("text '") + text + _("': expected") + describe(expected, keywords) + _(", found") + describe(actual, keywords));
+    }
+  }
+}
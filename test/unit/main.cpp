@@ -0,0 +1,77 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include "unit_test.hpp"
+
+// ----------------------------------------------------------------------------- : Registration
+
+UnitTest::UnitTest(const char* suite, const char* name, void (*run)())
+  : suite(suite), name(name), run(run)
+{
+  unit_tests().push_back(this);
+}
+
+vector<UnitTest*>& unit_tests() {
+  static vector<UnitTest*> tests;
+  return tests;
+}
+
+static int failed_checks = 0;
+
+void check_failed(const char* file, int line, const char* expression, const String& details) {
+  ++failed_checks;
+  fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+  if (!details.empty()) {
+    fprintf(stderr, "  %s\n", (const char*)details.ToUTF8());
+  }
+}
+
+// ----------------------------------------------------------------------------- : Main
+
+/// Runs the unit tests of the suites given on the command line, or all tests
+/** This is a wxApp, because some tests need fonts and device contexts.
+ */
+class UnitTestApp : public wxApp {
+public:
+  bool OnInit() override { return true; }
+  int OnRun() override;
+};
+
+IMPLEMENT_APP_CONSOLE(UnitTestApp)
+
+int UnitTestApp::OnRun() {
+  wxInitAllImageHandlers();
+  set<string> suites;
+  for (int i = 1 ; i < argc ; ++i) {
+    suites.insert(string(argv[i].ToUTF8()));
+  }
+  int tests = 0, failed_tests = 0;
+  FOR_EACH(test, unit_tests()) {
+    if (!suites.empty() && !suites.count(test->suite)) continue;
+    int failed_before = failed_checks;
+    try {
+      test->run();
+    } catch (const Error& e) {
+      check_failed(test->suite, 0, "no exception", e.what());
+    }
+    ++tests;
+    if (failed_checks != failed_before) {
+      ++failed_tests;
+      fprintf(stderr, "FAILED %s.%s\n", test->suite, test->name);
+    } else {
+      printf("ok     %s.%s\n", test->suite, test->name);
+    }
+  }
+  printf("%d tests, %d failed\n", tests, failed_tests);
+  if (tests == 0) {
+    fprintf(stderr, "no tests found\n");
+    return EXIT_FAILURE;
+  }
+  return failed_tests ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <util/order_cache.hpp>
+#include "unit_test.hpp"
+#include <random>
+
+// ----------------------------------------------------------------------------- : Incremental updates
+
+class TestItem : public IntrusivePtrBase<TestItem> {};
+typedef intrusive_ptr<TestItem> TestItemP;
+
+// Changing some items and updating them should give the same positions as ordering everything again
+TEST_CASE(order_cache, update_matches_fresh_cache) {
+  std::mt19937 rng(2468);
+  // few distinct values, so there are many ties
+  auto random_value = [&]() { return String::Format(_("v%d"), (int)(rng() % 10)); };
+  for (int round = 0 ; round < 50 ; ++round) {
+    size_t n = 1 + rng() % 40;
+    bool filtered = round % 2 == 1;
+    vector<TestItemP> keys;
+    vector<String>    values;
+    vector<int>       keep;
+    for (size_t i = 0 ; i < n ; ++i) {
+      keys.push_back(make_intrusive<TestItem>());
+      values.push_back(random_value());
+      keep.push_back(!filtered || rng() % 3 != 0);
+    }
+    OrderCache<TestItemP> cache(keys, values, filtered ? &keep : nullptr);
+    for (int step = 0 ; step < 10 ; ++step) {
+      // change some of the items, some more than once
+      set<size_t> changed;
+      size_t changes = rng() % 5;
+      for (size_t c = 0 ; c < changes ; ++c) {
+        size_t i = rng() % n;
+        values[i] = random_value();
+        if (filtered) keep[i] = rng() % 3 != 0;
+        cache.invalidate(keys[i]);
+        changed.insert(i);
+      }
+      // each changed item is reported once
+      vector<TestItemP> invalidated = cache.takeInvalidated();
+      CHECK_EQUAL(invalidated.size(), changed.size());
+      FOR_EACH(key, invalidated) {
+        size_t i = find(keys.begin(), keys.end(), key) - keys.begin();
+        CHECK(changed.count(i) == 1);
+        if (i < n) cache.update(key, values[i], !filtered || keep[i]);
+      }
+      CHECK(cache.takeInvalidated().empty());
+      // compare with a new cache
+      OrderCache<TestItemP> fresh(keys, values, filtered ? &keep : nullptr);
+      CHECK_EQUAL(cache.size(), fresh.size());
+      for (size_t i = 0 ; i < n ; ++i) {
+        CHECK_MSG(cache.find(keys[i]) == fresh.find(keys[i]),
+                  String::Format(_("round %d, step %d, item %d: position %d after updates, %d in a new cache"),
+                                 round, step, (int)i, cache.find(keys[i]), fresh.find(keys[i])));
+      }
+    }
+  }
+}
+
+TEST_CASE(order_cache, unknown_keys) {
+  vector<TestItemP> keys = {make_intrusive<TestItem>(), make_intrusive<TestItem>()};
+  vector<String> values = {_("b"), _("a")};
+  OrderCache<TestItemP> cache(keys, values);
+  CHECK_EQUAL(cache.find(keys[0]), 1);
+  CHECK_EQUAL(cache.find(keys[1]), 0);
+  TestItemP other = make_intrusive<TestItem>();
+  CHECK_EQUAL(cache.find(other), -1);
+  cache.invalidate(other);
+  CHECK(cache.takeInvalidated().empty());
+  cache.update(other, _("c"), true);
+  CHECK_EQUAL(cache.size(), 2);
+}
@@ -0,0 +1,121 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <util/tagged_string.hpp>
+#include "unit_test.hpp"
+#include <random>
+
+// ----------------------------------------------------------------------------- : Random tagged strings
+
+// Generates well formed tagged strings, with the tags that the cursor functions treat specially
+class TaggedStringGenerator {
+public:
+  TaggedStringGenerator(unsigned int seed) : rng(seed) {}
+  
+  String generate() {
+    String out;
+    if (chance(4)) out += _("<prefix>") + text(1) + _("</prefix>");
+    out += text(3);
+    if (chance(4)) out += _("<suffix>") + text(1) + _("</suffix>");
+    return out;
+  }
+  
+private:
+  std::mt19937 rng;
+  
+  bool chance(unsigned int one_in) { return rng() % one_in == 0; }
+  
+  // a sequence of characters and nested tags
+  String text(int depth) {
+    String out;
+    size_t parts = rng() % 6;
+    for (size_t i = 0 ; i < parts ; ++i) {
+      switch (depth > 0 ? rng() % 8 : 0) {
+        case 0: case 1: case 2: out += String(_("ab c")).substr(rng() % 4, 1 + rng() % 2); break;
+        case 3: out += _("<b>")          + text(depth - 1) + _("</b>");          break;
+        case 4: out += _("<kw-a>")       + text(depth - 1) + _("</kw-a>");       break;
+        case 5: out += _("<atom-param>") + text(depth - 1) + _("</atom-param>"); break;
+        case 6: out += _("<sep>")        + text(0)         + _("</sep>");        break;
+        case 7: out += _("<sep-soft>")   + text(0)         + _("</sep-soft>");   break;
+      }
+    }
+    return out;
+  }
+};
+
+// ----------------------------------------------------------------------------- : Compare with the string functions
+
+static const Movement movements[] = {MOVE_LEFT, MOVE_LEFT_OPT, MOVE_MID, MOVE_RIGHT_OPT, MOVE_RIGHT};
+
+#define CHECK_SAME(a, b, what)                                                             \
+  CHECK_MSG((a) == (b), String::Format(_("'%s', %s: TaggedText gives %d, string functions give %d"), \
+                                       str, what, (int)(a), (int)(b)))
+
+static void check_tagged_text(const String& str) {
+  TaggedText t(str);
+  CHECK_MSG(t.untagged() == untag(str), _("'") + str + _("': untagged"));
+  CHECK_SAME(t.cursorCount(), index_to_cursor(str, String::npos), _("cursorCount"));
+  for (size_t index = 0 ; index <= str.size() + 1 ; ++index) {
+    for (Movement dir : movements) {
+      CHECK_SAME(t.indexToCursor(index, dir), index_to_cursor(str, index, dir),
+                 String::Format(_("indexToCursor(%d, %d)"), (int)index, (int)dir));
+    }
+    CHECK_SAME(t.indexToUntagged(index), index_to_untagged(str, index),
+               String::Format(_("indexToUntagged(%d)"), (int)index));
+  }
+  for (size_t cursor = 0 ; cursor <= t.cursorCount() + 1 ; ++cursor) {
+    size_t begin, end, begin2, end2;
+    t.cursorToIndexRange(cursor, begin, end);
+    cursor_to_index_range(str, cursor, begin2, end2);
+    CHECK_SAME(begin, begin2, String::Format(_("cursorToIndexRange(%d).begin"), (int)cursor));
+    CHECK_SAME(end,   end2,   String::Format(_("cursorToIndexRange(%d).end"),   (int)cursor));
+    for (Movement dir : movements) {
+      CHECK_SAME(t.cursorToIndex(cursor, dir), cursor_to_index(str, cursor, dir),
+                 String::Format(_("cursorToIndex(%d, %d)"), (int)cursor, (int)dir));
+    }
+  }
+  for (size_t pos = 0 ; pos <= t.untagged().size() + 1 ; ++pos) {
+    for (bool inside : {false, true}) {
+      CHECK_SAME(t.untaggedToIndex(pos, inside), untagged_to_index(str, pos, inside),
+                 String::Format(_("untaggedToIndex(%d, %d)"), (int)pos, (int)inside));
+    }
+  }
+  for (size_t start = 0 ; start <= str.size() ; ++start) {
+    for (size_t end = start ; end <= str.size() ; ++end) {
+      for (const Char* tag : {_("<b"), _("<kw-"), _("<atom")}) {
+        CHECK_SAME(t.isInTag(tag, start, end), is_in_tag(str, tag, start, end),
+                   String::Format(_("isInTag(%s, %d, %d)"), tag, (int)start, (int)end));
+      }
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------- : Tests
+
+TEST_CASE(tagged_text, fixed_strings) {
+  const Char* strings[] = {
+    _(""),
+    _("abc"),
+    _("<b>abc</b>"),
+    _("a<atom-param>bc</atom-param>d"),
+    _("<atom-param></atom-param>"),
+    _("<prefix>x</prefix>abc<suffix>y</suffix>"),
+    _("<kw-a><b>ab</b><sep> </sep>c</kw-a>"),
+  };
+  for (const Char* str : strings) {
+    check_tagged_text(str);
+  }
+}
+
+TEST_CASE(tagged_text, random_strings) {
+  TaggedStringGenerator generator(4321);
+  for (int i = 0 ; i < 500 ; ++i) {
+    check_tagged_text(generator.generate());
+  }
+}
@@ -0,0 +1,57 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+#include <util/rotation.hpp>
+#include "unit_test.hpp"
+
+// ----------------------------------------------------------------------------- : Measuring by line vs by prefix
+
+// Text layout used to measure the width of each prefix of a line with GetTextExtent,
+// it now measures a line at once with GetPartialTextExtents. Both should give identical widths.
+// RotatedDC divides both by the same scale, so equal device units give equal results.
+// The texts of a real set can be checked with ":benchmark extents" in the command line interface.
+
+static const Char* sample_lines[] = {
+  _("Flying"),
+  _("When Pineapple of Doom enters the battlefield, draw a card."),
+  _("{T}: Add one mana of any color to your mana pool."),
+  _("AVAWAY  double  spaces, punctuation!?"),
+  _("\u00dcn\u00efc\u00f6d\u00e9 \u00dftrings \u2014 with dashes and \u201cquotes\u201d"),
+};
+
+static void check_partial_extents(RotatedDC& dc) {
+  for (const Char* line_chars : sample_lines) {
+    String line = line_chars;
+    vector<double> widths;
+    RealSize size = dc.GetPartialTextExtents(line, widths);
+    CHECK_EQUAL(widths.size(), line.size());
+    if (widths.size() != line.size()) continue;
+    for (size_t i = 1 ; i <= line.size() ; ++i) {
+      RealSize prefix = dc.GetTextExtent(line.substr(0, i));
+      CHECK_MSG(prefix.width == widths[i-1],
+                String::Format(_("prefix '%s': %f by prefix, %f by line"), line.substr(0, i), prefix.width, widths[i-1]));
+    }
+    RealSize whole = dc.GetTextExtent(line);
+    CHECK_MSG(whole.width == size.width && whole.height == size.height,
+              String::Format(_("line '%s': %fx%f by prefix, %fx%f by line"), line, whole.width, whole.height, size.width, size.height));
+  }
+}
+
+TEST_CASE(text_extent, partial_extents_match_prefixes) {
+  Bitmap bitmap(400, 100);
+  wxMemoryDC mdc;
+  mdc.SelectObject(bitmap);
+  wxFont font(12, wxFONTFAMILY_SWISS, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
+  for (RenderQuality quality : {QUALITY_LOW, QUALITY_AA}) {
+    RotatedDC dc(mdc, 0, RealRect(0, 0, 400, 100), 1.0, quality);
+    dc.SetFont(font);
+    check_partial_extents(dc);
+  }
+  mdc.SelectObject(wxNullBitmap);
+}
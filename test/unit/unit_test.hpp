@@ -0,0 +1,49 @@
+//+----------------------------------------------------------------------------+
+//| Description:  Magic Set Editor - Program to make Magic (tm) cards          |
+//| Copyright:    (C) Twan van Laarhoven and the other MSE developers          |
+//| License:      GNU General Public License 2 or later (see file COPYING)     |
+//+----------------------------------------------------------------------------+
+
+#pragma once
+
+// ----------------------------------------------------------------------------- : Includes
+
+#include <util/prec.hpp>
+
+// ----------------------------------------------------------------------------- : Unit tests
+
+/// A unit test of some internal data structure or algorithm
+/** Tests are grouped in suites, one suite per file in test/unit,
+ *  each suite is run as a separate ctest test.
+ */
+struct UnitTest {
+  UnitTest(const char* suite, const char* name, void (*run)());
+  const char* suite;
+  const char* name;
+  void (*run)();
+};
+
+/// All unit tests that were declared with TEST_CASE
+vector<UnitTest*>& unit_tests();
+
+/// Report a failed check, the test continues
+void check_failed(const char* file, int line, const char* expression, const String& details = String());
+
+/// Declare a unit test, followed by its body
+#define TEST_CASE(suite, name)                                          \
+  static void test_##suite##_##name();                                  \
+  static UnitTest unit_test_##suite##_##name(#suite, #name, test_##suite##_##name); \
+  static void test_##suite##_##name()
+
+/// Check that a condition holds
+#define CHECK(cond)                                                     \
+  ((cond) ? (void)0 : check_failed(__FILE__, __LINE__, #cond))
+
+/// Check that two values are equal, and show both values if they are not
+#define CHECK_EQUAL(a, b)                                               \
+  (((a) == (b)) ? (void)0 : check_failed(__FILE__, __LINE__, #a " == " #b, \
+                                         String() << (a) << _(" != ") << (b)))
+
+/// Check a condition, with extra details to show when it fails
+#define CHECK_MSG(cond, details)                                        \
+  ((cond) ? (void)0 : check_failed(__FILE__, __LINE__, #cond, details))